@@ -0,0 +1,144 @@
+/*
+  Force Feedback Joystick
+  Merged response of stacked condition effects.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+
+#include "FfbConditionCurve.h"
+
+float FfbConditionCurve::Response(float metric, const USB_FFBReport_SetCondition_Output_Data_t &condition, const TResponseCurve *curve)
+{
+  uint16_t deadBand = condition.deadBand;
+  int16_t cpOffset = condition.cpOffset;
+  uint16_t negativeCoefficient = condition.negativeCoefficient;
+  int16_t negativeSaturation = -condition.negativeSaturation;
+  uint16_t positiveSaturation = condition.positiveSaturation;
+  uint16_t positiveCoefficient = condition.positiveCoefficient;
+
+  float tempForce = 0;
+
+  if (metric < (cpOffset - deadBand))
+  {
+    tempForce = -Shape((cpOffset - deadBand) - metric, curve) * negativeCoefficient / USB_AXIS_MAX_ABSOLUTE;
+    if (tempForce < negativeSaturation)
+      tempForce = negativeSaturation;
+  }
+  else if (metric > (cpOffset + deadBand))
+  {
+    tempForce = Shape(metric - (cpOffset + deadBand), curve) * positiveCoefficient / USB_AXIS_MAX_ABSOLUTE;
+    if (tempForce > positiveSaturation)
+      tempForce = positiveSaturation;
+  }
+
+  return -tempForce;
+}
+
+float FfbConditionCurve::Shape(float distance, const TResponseCurve *curve)
+{
+  if (curve == nullptr)
+    return distance;
+
+  // the points are evenly spaced over the metric range, the last one holds beyond it
+  float position = distance * (curve->pointCount - 1) / USB_AXIS_MAX_ABSOLUTE;
+  if (position >= curve->pointCount - 1)
+    return (float)curve->points[curve->pointCount - 1] * USB_AXIS_MAX_ABSOLUTE / USB_MAX_RESPONSE_CURVE_POINT;
+
+  uint8_t point = position;
+  float fraction = position - point;
+  float point0 = curve->points[point];
+  float point1 = curve->points[point + 1];
+  return (point0 + (point1 - point0) * fraction) * USB_AXIS_MAX_ABSOLUTE / USB_MAX_RESPONSE_CURVE_POINT;
+}
+
+void FfbConditionCurve::Reset()
+{
+  count = 0;
+}
+
+bool FfbConditionCurve::Add(const USB_FFBReport_SetCondition_Output_Data_t &condition, float scale)
+{
+  float negativeEdge = condition.cpOffset - condition.deadBand;
+  float positiveEdge = condition.cpOffset + condition.deadBand;
+
+  if (!Insert(negativeEdge) || !Insert(positiveEdge))
+    return false;
+  // metric where the response reaches saturation
+  if (condition.negativeCoefficient != 0 &&
+      !Insert(negativeEdge - (float)condition.negativeSaturation * USB_AXIS_MAX_ABSOLUTE / condition.negativeCoefficient))
+    return false;
+  if (condition.positiveCoefficient != 0 &&
+      !Insert(positiveEdge + (float)condition.positiveSaturation * USB_AXIS_MAX_ABSOLUTE / condition.positiveCoefficient))
+    return false;
+
+  // the sum is linear between breakpoints, so adding the values at the breakpoints adds the functions
+  for (uint8_t i = 0; i < count; ++i)
+  {
+    forces[i] += Response(breakpoints[i], condition) * scale;
+  }
+  return true;
+}
+
+bool FfbConditionCurve::Insert(float metric)
+{
+  uint8_t position = 0;
+  while (position < count && breakpoints[position] < metric)
+    ++position;
+
+  if (position < count && breakpoints[position] == metric)
+    return true;
+  if (count == FFB_MAX_CONDITION_BREAKPOINTS)
+    return false;
+
+  // a breakpoint on the existing curve does not change it
+  float force = Evaluate(metric);
+  for (uint8_t i = count; i > position; --i)
+  {
+    breakpoints[i] = breakpoints[i - 1];
+    forces[i] = forces[i - 1];
+  }
+  breakpoints[position] = metric;
+  forces[position] = force;
+  ++count;
+  return true;
+}
+
+float FfbConditionCurve::Evaluate(float metric) const
+{
+  if (count == 0)
+    return 0;
+  if (metric <= breakpoints[0])
+    return forces[0];
+  if (metric >= breakpoints[count - 1])
+    return forces[count - 1];
+
+  // first breakpoint above metric
+  uint8_t low = 1, high = count - 1;
+  while (low < high)
+  {
+    uint8_t mid = (low + high) / 2;
+    if (breakpoints[mid] <= metric)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  float x0 = breakpoints[low - 1], x1 = breakpoints[low];
+  return forces[low - 1] + (forces[low] - forces[low - 1]) * (metric - x0) / (x1 - x0);
+}
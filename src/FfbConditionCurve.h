@@ -0,0 +1,56 @@
+/*
+  Force Feedback Joystick
+  Merged response of stacked condition effects.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBCONDITIONCURVE_h
+#define FFBCONDITIONCURVE_h
+
+#include "HIDReportType.h"
+
+// Breakpoints of one merged response, each condition adds up to 4
+#ifndef FFB_MAX_CONDITION_BREAKPOINTS
+#define FFB_MAX_CONDITION_BREAKPOINTS 16
+#endif
+
+// Sum of condition responses on one axis as a piecewise-linear function of the metric.
+// Every condition saturates on both sides, so the sum is flat outside of the outer breakpoints.
+class FfbConditionCurve
+{
+public:
+  // force of a single condition at metric, before effect gain, shaped by curve when it has one
+  static float Response(float metric, const USB_FFBReport_SetCondition_Output_Data_t &condition, const TResponseCurve *curve = nullptr);
+
+  void Reset();
+  // adds condition scaled by scale, returns false when its breakpoints do not fit and the curve is no longer valid
+  bool Add(const USB_FFBReport_SetCondition_Output_Data_t &condition, float scale);
+  float Evaluate(float metric) const;
+
+private:
+  // metric beyond the dead band after the curve, the identity without one
+  static float Shape(float distance, const TResponseCurve *curve);
+  bool Insert(float metric);
+
+  float breakpoints[FFB_MAX_CONDITION_BREAKPOINTS];
+  float forces[FFB_MAX_CONDITION_BREAKPOINTS];
+  uint8_t count = 0;
+};
+
+#endif
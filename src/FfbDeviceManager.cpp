@@ -0,0 +1,77 @@
+/*
+  Force Feedback Joystick
+  Host side manager running many emulated force feedback devices.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#include "FfbDeviceManager.h"
+#include <chrono>
+
+FfbDeviceManager::FfbDeviceManager(uint32_t count, uint16_t workerCount, bool pinToCores) : deviceCount{count},
+                                                                                           devices{new FfbDevice[count]},
+                                                                                           workerPool{workerCount, pinToCores}
+{
+}
+
+void FfbDeviceManager::Tick(uint64_t time)
+{
+  tickTime = time;
+  workerPool.Run(TickDevice, this, deviceCount);
+}
+
+void FfbDeviceManager::TickDevice(void *context, uint32_t deviceIdx)
+{
+  FfbDeviceManager *manager = (FfbDeviceManager *)context;
+  FfbDevice &device = manager->devices[deviceIdx];
+
+  auto start = std::chrono::steady_clock::now();
+  device.engine.ForceCalculator(manager->tickTime, device.force);
+  auto end = std::chrono::steady_clock::now();
+
+  uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  TFfbTickStats &stats = device.stats;
+  ++stats.ticks;
+  stats.lastNanos = nanos;
+  stats.totalNanos += nanos;
+  if (nanos < stats.minNanos)
+    stats.minNanos = nanos;
+  if (nanos > stats.maxNanos)
+    stats.maxNanos = nanos;
+}
+
+uint32_t FfbDeviceManager::GetDeviceCount() const
+{
+  return deviceCount;
+}
+
+FfbDevice &FfbDeviceManager::GetDevice(uint32_t deviceIdx)
+{
+  return devices[deviceIdx];
+}
+
+const TFfbTickStats &FfbDeviceManager::GetStats(uint32_t deviceIdx) const
+{
+  return devices[deviceIdx].stats;
+}
+
+void FfbDeviceManager::ResetStats()
+{
+  for (uint32_t i = 0; i < deviceCount; ++i)
+    devices[i].stats = {0, 0, UINT64_MAX, 0, 0};
+}
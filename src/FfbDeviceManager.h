@@ -0,0 +1,81 @@
+/*
+  Force Feedback Joystick
+  Host side manager running many emulated force feedback devices.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBDEVICEMANAGER_h
+#define FFBDEVICEMANAGER_h
+
+#include <memory>
+#include "HIDReportType.h"
+#include "FfbReportHandler.h"
+#include "FfbEngine.h"
+#include "UserInput.h"
+#include "FfbWorkerPool.h"
+
+typedef struct
+{
+  uint64_t ticks;
+  uint64_t lastNanos;
+  uint64_t minNanos;
+  uint64_t maxNanos;
+  uint64_t totalNanos;
+} TFfbTickStats;
+
+// One emulated device. Aligned to a cache line so devices ticked on different workers do not share lines.
+struct alignas(64) FfbDevice
+{
+  FfbDevice() : engine{reportHandler, userInput} {}
+  FfbDevice(const FfbDevice &) = delete;
+  FfbDevice &operator=(const FfbDevice &) = delete;
+
+  UserInput userInput;
+  FfbReportHandler reportHandler;
+  FfbEngine engine;
+  int32_t force[NUM_AXES] = {0};
+  TFfbTickStats stats = {0, 0, UINT64_MAX, 0, 0};
+};
+
+// Owns independent report handler, engine and user input sets in one contiguous array and ticks them
+// on a fixed worker pool. Device i is always ticked by worker i % workerCount.
+// Reports and user input may be fed to a device only while Tick is not running.
+class FfbDeviceManager
+{
+public:
+  FfbDeviceManager(uint32_t deviceCount, uint16_t workerCount, bool pinToCores = false);
+
+  // Runs Advance and Evaluate of every device at the given device time, outputs are in FfbDevice::force
+  void Tick(uint64_t time);
+
+  uint32_t GetDeviceCount() const;
+  FfbDevice &GetDevice(uint32_t deviceIdx);
+  const TFfbTickStats &GetStats(uint32_t deviceIdx) const;
+  void ResetStats();
+
+private:
+  static void TickDevice(void *context, uint32_t deviceIdx);
+
+  uint32_t deviceCount;
+  std::unique_ptr<FfbDevice[]> devices;
+  FfbWorkerPool workerPool;
+  uint64_t tickTime = 0;
+};
+
+#endif
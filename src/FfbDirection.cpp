@@ -0,0 +1,122 @@
+/*
+  Force Feedback Joystick
+  Effect direction angles to unit vectors without trigonometric calls.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+
+#include "FfbDirection.h"
+
+// angle = coarse * FFB_ANGLE_FINE_STEPS + fine, sin and cos come from the angle addition formulas
+#define FFB_ANGLE_FINE_STEPS 80
+#define FFB_ANGLE_COARSE_STEPS (USB_MAX_PHASE / FFB_ANGLE_FINE_STEPS + 1)
+
+namespace
+{
+  // the tables hold floats, so the targets without a double FPU multiply them in hardware
+  typedef struct
+  {
+    float sinValue;
+    float cosValue;
+  } TSinCos;
+
+  typedef struct
+  {
+    double sinValue;
+    double cosValue;
+  } TSinCosExact;
+
+  template <uint16_t Count>
+  struct TSinCosTable
+  {
+    TSinCos values[Count];
+  };
+
+  // Taylor series around the nearest multiple of pi / 2, evaluated by the compiler
+  constexpr TSinCosExact SinCos(double angle)
+  {
+    const double halfPi = 1.57079632679489661923;
+    int quadrant = (int)(angle / halfPi + 0.5);
+    double x = angle - quadrant * halfPi;
+
+    double sinValue = 0, cosValue = 0;
+    double sinTerm = x, cosTerm = 1;
+    for (int n = 0; n < 12; ++n)
+    {
+      sinValue += sinTerm;
+      cosValue += cosTerm;
+      sinTerm *= -x * x / ((2 * n + 2) * (2 * n + 3));
+      cosTerm *= -x * x / ((2 * n + 1) * (2 * n + 2));
+    }
+
+    switch (quadrant % 4)
+    {
+    case 0:
+      return {sinValue, cosValue};
+    case 1:
+      return {cosValue, -sinValue};
+    case 2:
+      return {-sinValue, -cosValue};
+    default:
+      return {-cosValue, sinValue};
+    }
+  }
+
+  template <uint16_t Count>
+  constexpr TSinCosTable<Count> MakeTable(uint16_t step)
+  {
+    TSinCosTable<Count> table = {};
+    for (uint16_t i = 0; i < Count; ++i)
+    {
+      TSinCosExact value = SinCos((double)i * step / USB_NORMALIZE_RAD);
+      table.values[i] = {(float)value.sinValue, (float)value.cosValue};
+    }
+    return table;
+  }
+
+  constexpr TSinCosTable<FFB_ANGLE_COARSE_STEPS> coarseTable = MakeTable<FFB_ANGLE_COARSE_STEPS>(FFB_ANGLE_FINE_STEPS);
+  constexpr TSinCosTable<FFB_ANGLE_FINE_STEPS> fineTable = MakeTable<FFB_ANGLE_FINE_STEPS>(1);
+}
+
+void FfbSinCos(uint16_t angle, float &sinValue, float &cosValue)
+{
+  angle %= USB_MAX_PHASE + 1;
+
+  const TSinCos &coarse = coarseTable.values[angle / FFB_ANGLE_FINE_STEPS];
+  const TSinCos &fine = fineTable.values[angle % FFB_ANGLE_FINE_STEPS];
+
+  sinValue = coarse.sinValue * fine.cosValue + coarse.cosValue * fine.sinValue;
+  cosValue = coarse.cosValue * fine.cosValue - coarse.sinValue * fine.sinValue;
+}
+
+void FfbDirectionToUnitVec(const uint16_t *angles, uint8_t angleCount, float *unitVec, uint8_t axisCount)
+{
+  float sinProduct = 1;
+  for (uint8_t i = 0; i + 1 < axisCount; ++i)
+  {
+    float sinValue = 0, cosValue = 1;
+    if (i < angleCount)
+      FfbSinCos(angles[i], sinValue, cosValue);
+
+    unitVec[i] = sinProduct * cosValue;
+    sinProduct *= sinValue;
+  }
+  if (axisCount > 0)
+    unitVec[axisCount - 1] = sinProduct;
+}
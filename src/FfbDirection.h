@@ -0,0 +1,36 @@
+/*
+  Force Feedback Joystick
+  Effect direction angles to unit vectors without trigonometric calls.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBDIRECTION_h
+#define FFBDIRECTION_h
+
+#include "HIDReportType.h"
+
+// sine and cosine of angle in HID units (1/1000 rad, 0..USB_MAX_PHASE), larger angles wrap
+void FfbSinCos(uint16_t angle, float &sinValue, float &cosValue);
+
+// Unit vector of polar direction angles in HID units for axisCount axes, axisCount - 1 angles are used.
+// unitVec[0] = cos(a0), unitVec[1] = sin(a0) cos(a1), ... unitVec[axisCount - 1] = sin(a0) ... sin(aN-2).
+// Missing angles are 0, so with two axes this is the usual (cos, sin) of the first angle.
+void FfbDirectionToUnitVec(const uint16_t *angles, uint8_t angleCount, float *unitVec, uint8_t axisCount);
+
+#endif
@@ -40,12 +40,12 @@ FfbEngine::~FfbEngine()
 {
 }
 
-float FfbEngine::ConstantForceCalculator(const TEffectState &effect)
+float FfbEngine::ConstantForceCalculator(const TEffectState &effect) const
 {
   return effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].constant.magnitude;
 }
 
-float FfbEngine::RampForceCalculator(const TEffectState &effect, float elapsedTime)
+float FfbEngine::RampForceCalculator(const TEffectState &effect, float elapsedTime) const
 {
   const USB_FFBReport_SetRampForce_Output_Data_t &ramp = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].ramp;
 
@@ -53,7 +53,7 @@ float FfbEngine::RampForceCalculator(const TEffectState &effect, float elapsedTi
   return tempForce;
 }
 
-float FfbEngine::PeriodiceForceCalculator(uint8_t effectType, const TEffectState &effect, float elapsedTime)
+float FfbEngine::PeriodiceForceCalculator(uint8_t effectType, const TEffectState &effect, float elapsedTime) const
 {
   const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
 
@@ -116,36 +116,55 @@ float FfbEngine::PeriodiceForceCalculator(uint8_t effectType, const TEffectState
   return tempForce;
 }
 
-int32_t ApplyCondition(int32_t metric, uint8_t gain, const USB_FFBReport_SetCondition_Output_Data_t &condition)
+float FfbEngine::CustomForceCalculator(const TEffectState &effect, float elapsedTime) const
 {
-  uint16_t deadBand = condition.deadBand;
-  int16_t cpOffset = condition.cpOffset;
-  uint16_t negativeCoefficient = condition.negativeCoefficient;
-  int16_t negativeSaturation = -condition.negativeSaturation;
-  uint16_t positiveSaturation = condition.positiveSaturation;
-  uint16_t positiveCoefficient = condition.positiveCoefficient;
+  const TCustomForce *customForce = ffbReportHandler.GetCustomForce(&effect - ffbReportHandler.GetEffectStates());
+  if (customForce == nullptr)
+    return 0;
 
-  float tempForce = 1.0 / USB_AXIS_MAX_ABSOLUTE;
+  uint16_t sampleCount = customForce->sampleCount != 0 ? customForce->sampleCount : customForce->writtenCount;
+  if (sampleCount == 0)
+    return 0;
 
-  if (metric < (cpOffset - deadBand))
-  {
-    tempForce *= (metric - (cpOffset - deadBand)) * negativeCoefficient;
-    if (tempForce < negativeSaturation)
-      tempForce = negativeSaturation;
-  }
-  else if (metric > (cpOffset + deadBand))
-  {
-    tempForce *= (metric - (cpOffset + deadBand)) * positiveCoefficient;
-    if (tempForce > positiveSaturation)
-      tempForce = positiveSaturation;
-  }
+  uint16_t samplePeriod = customForce->samplePeriod;
+  if (samplePeriod == 0)
+    samplePeriod = effect.block.samplePeriod;
+  if (samplePeriod == 0)
+    samplePeriod = 1;
+
+  // the samples repeat every sampleCount samples, values between samples are interpolated
+  float position = elapsedTime / samplePeriod;
+  uint32_t sample = position;
+  float fraction = position - sample;
+  sample %= sampleCount;
+  float sample0 = customForce->samples[sample];
+  float sample1 = customForce->samples[(sample + 1) % sampleCount];
+
+  return (sample0 + (sample1 - sample0) * fraction) * USB_MAX_MAGNITUDE / USB_MAX_CUSTOM_SAMPLE;
+}
+
+float FfbEngine::WavetableForceCalculator(const TEffectState &effect, const TWavetable *wavetable, float elapsedTime) const
+{
+  const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+  float offset = periodic.offset;
+  if (wavetable == nullptr || wavetable->pointCount == 0 || periodic.period == 0)
+    return offset;
 
-  return -tempForce;
+  // one pass through the table per period, with the same phase as PeriodiceForceCalculator
+  float phaseNormalized = (float)periodic.phase / USB_MAX_PHASE;
+  float cycle = elapsedTime / periodic.period + phaseNormalized;
+  float position = (cycle - floorf(cycle)) * wavetable->pointCount;
+  uint16_t point = position;
+  float fraction = position - point;
+  point %= wavetable->pointCount;
+  float point0 = wavetable->points[point];
+  float point1 = wavetable->points[(point + 1) % wavetable->pointCount];
+
+  return offset + (point0 + (point1 - point0) * fraction) * periodic.magnitude / USB_MAX_WAVETABLE_POINT;
 }
 
-void FfbEngine::ConditionForceCalculator(const TEffectState &effect, const int32_t metric[NUM_AXES], float outForce[NUM_AXES])
+void FfbEngine::ConditionForceCalculator(const TEffectState &effect, const int32_t metric[NUM_AXES], float outForce[NUM_AXES]) const
 {
-  uint8_t gain = (float)effect.block.gain;
   uint8_t enableAxis = effect.block.enableAxis;
 
   if (enableAxis & DIRECTION_ENABLE)
@@ -158,7 +177,7 @@ void FfbEngine::ConditionForceCalculator(const TEffectState &effect, const int32
       metricComponent += metric[i] * effect.directionUnitVec[i];
     }
 
-    float tempForce = ApplyCondition(metricComponent, gain, condition);
+    float tempForce = FfbConditionCurve::Response(metricComponent, condition, GetResponseCurve(effect, TYPE_SPECIFIC_BLOCK_OFFSET_1));
 
     for (uint8_t i = 0; i < NUM_AXES; ++i) // split the force to components in axis directions
     {
@@ -174,131 +193,599 @@ void FfbEngine::ConditionForceCalculator(const TEffectState &effect, const int32
       continue;
 
     USB_FFBReport_SetCondition_Output_Data_t condition = effect.parameters[i].condition;
-    outForce[i] = ApplyCondition(metric[i], gain, condition);
+    outForce[i] = FfbConditionCurve::Response(metric[i], condition, GetResponseCurve(effect, i));
   }
 }
 
 void FfbEngine::ForceCalculator(int32_t ffbForce[NUM_AXES])
 {
+  ForceCalculator(getTimeMilli != nullptr ? getTimeMilli() : lastTime, ffbForce);
+}
+
+void FfbEngine::ForceCalculator(uint64_t deviceTime, int32_t ffbForce[NUM_AXES])
+{
+  Advance(deviceTime);
+
+  // the hook may depend on more than its arguments, so its results are never reused
+  if (ffbReportHandler.devicePaused || forceHook != nullptr)
+  {
+    Evaluate(deviceTime, ffbForce);
+    return;
+  }
+
+  uint64_t time = ffbReportHandler.GetEffectTime(deviceTime);
+  uint32_t reportRevision = ffbReportHandler.GetRevision();
+  uint32_t inputRevision = axisPosition.GetRevision();
+
+  // a report or a scheduler transition may change any effect, new inputs only change conditions
+  bool effectsChanged = !forceCache.valid || forceCache.reportRevision != reportRevision || time < forceCache.time;
+  bool inputsChanged = effectsChanged || forceCache.inputRevision != inputRevision;
+  if (inputsChanged)
+  {
+    // only active effects are summed, an effect that becomes active changes the revision and is reset then
+    const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+    uint8_t activeCount;
+    const uint8_t *activeEffects = ffbReportHandler.GetActiveEffects(activeCount);
+    for (uint8_t active = 0; active < activeCount; ++active)
+    {
+      uint8_t idx = activeEffects[active];
+      if (effectsChanged || GetConditionMetric(effectStates[idx].block.effectType) >= 0)
+        forceCache.effectValidUntil[idx] = 0;
+    }
+  }
+
+  // Time based effects are summed again when the earliest effect horizon passed, conditions when the inputs changed
+  if (effectsChanged || time >= forceCache.validUntil)
+  {
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      forceCache.timeForceSum[i] = 0;
+    }
+    forceCache.validUntil = FFB_TIME_NEVER;
+    EvaluateSum(time, forceCache.timeForceSum, &forceCache, timeEffects);
+  }
+  if (inputsChanged)
+  {
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      forceCache.conditionForceSum[i] = 0;
+    }
+    EvaluateSum(time, forceCache.conditionForceSum, &forceCache, conditionEffects);
+  }
+
+  forceCache.valid = true;
+  forceCache.reportRevision = reportRevision;
+  forceCache.inputRevision = inputRevision;
+  forceCache.time = time;
+
+  float forceSum[NUM_AXES];
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    forceSum[i] = forceCache.timeForceSum[i] + forceCache.conditionForceSum[i];
+  }
+  // streamed samples change without a new revision, they are never cached
+  ffbReportHandler.AddStreamForce(deviceTime, forceSum);
+  ApplyDeviceGain(forceSum, ffbForce);
+}
+
+void FfbEngine::SetRenderPeriod(uint16_t period)
+{
+  renderPeriod = period == 0 ? 1 : period;
+  forceCache.valid = false;
+}
+
+void FfbEngine::Advance(uint64_t deviceTime)
+{
+  lastTime = deviceTime;
+  ffbReportHandler.FlushPendingReports();
+  // bulk updates modulate the parameters set by the reports
+  ffbReportHandler.ApplyBulkUpdates();
+  ffbReportHandler.ApplyTimedOperations(deviceTime);
   if (ffbReportHandler.devicePaused)
+    return;
+
+  uint64_t time = ffbReportHandler.GetEffectTime(deviceTime);
+
+  uint8_t pressed, released;
+  if (axisPosition.ConsumeButtonEdges(pressed, released))
+    ffbReportHandler.UpdateTriggers(axisPosition.GetButtons(), pressed, released, time);
+  ffbReportHandler.AdvanceTimelines(time);
+  ffbReportHandler.AdvanceEffects(time);
+
+  if (!conditionCurves.valid || conditionCurves.revision != ffbReportHandler.GetRevision())
+    BuildConditionCurves();
+}
+
+uint8_t FfbEngine::GetEffectGroup(const TEffectState &effect)
+{
+  return GetConditionMetric(effect.block.effectType) >= 0 ? conditionEffects : timeEffects;
+}
+
+int8_t FfbEngine::GetConditionMetric(uint8_t effectType)
+{
+  switch (effectType)
+  {
+  case USB_EFFECT_SPRING:
+    return UserInput::position;
+  case USB_EFFECT_FRICTION:
+  case USB_EFFECT_DAMPER:
+    return UserInput::speed;
+  case USB_EFFECT_INERTIA:
+    return UserInput::acceleration;
+  default:
+    return -1;
+  }
+}
+
+void FfbEngine::BuildConditionCurves()
+{
+  const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+  uint8_t activeCount;
+  const uint8_t *activeEffects = ffbReportHandler.GetActiveEffects(activeCount);
+
+  for (uint8_t metric = 0; metric < UserInput::metricsCount; ++metric)
   {
+    // the force hook is called per effect, so with a hook every condition is evaluated on its own
+    conditionCurves.merged[metric] = forceHook == nullptr;
     for (uint8_t i = 0; i < NUM_AXES; ++i)
     {
-      ffbForce[i] = 0;
+      conditionCurves.curves[metric][i].Reset();
+    }
+  }
+
+  // conditions along a direction act on the projected metric and are evaluated on their own, as are
+  // conditions with a response curve, whose segments would not fit the merged breakpoints
+  for (uint8_t idx = 0; idx < activeCount; ++idx)
+  {
+    const TEffectState &effect = effectStates[activeEffects[idx]];
+    int8_t metric = GetConditionMetric(effect.block.effectType);
+    if (metric < 0 || (effect.block.enableAxis & DIRECTION_ENABLE) || !conditionCurves.merged[metric] ||
+        ffbReportHandler.HasResponseCurve(activeEffects[idx]))
+      continue;
+
+    float scale = (float)effect.block.gain / USB_MAX_GAIN;
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      if (!((effect.block.enableAxis >> i) & 0x01))
+        continue;
+      if (!conditionCurves.curves[metric][i].Add(effect.parameters[i].condition, scale))
+        conditionCurves.merged[metric] = false;
     }
+  }
+
+  conditionCurves.remainingCount = 0;
+  for (uint8_t idx = 0; idx < activeCount; ++idx)
+  {
+    const TEffectState &effect = effectStates[activeEffects[idx]];
+    int8_t metric = GetConditionMetric(effect.block.effectType);
+    if (metric < 0 || (effect.block.enableAxis & DIRECTION_ENABLE) || !conditionCurves.merged[metric] ||
+        ffbReportHandler.HasResponseCurve(activeEffects[idx]))
+      conditionCurves.remainingEffects[conditionCurves.remainingCount++] = activeEffects[idx];
+  }
+
+  conditionCurves.valid = true;
+  conditionCurves.revision = ffbReportHandler.GetRevision();
+}
+
+const TResponseCurve *FfbEngine::GetResponseCurve(const TEffectState &effect, uint8_t parameterBlockOffset) const
+{
+  const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+  if (&effect < effectStates || &effect >= effectStates + MAX_EFFECTS)
+    return nullptr;
+  return ffbReportHandler.GetResponseCurve(&effect - effectStates, parameterBlockOffset);
+}
+
+float FfbEngine::TimeEffectForce(const TEffectState &effect, uint8_t effectIdx, uint32_t elapsedTime) const
+{
+  uint8_t effectType = effect.block.effectType;
+  float force = 0;
+
+  switch (effectType)
+  {
+  case USB_EFFECT_CONSTANT:
+    force = ConstantForceCalculator(effect);
+    break;
+  case USB_EFFECT_RAMP:
+    force = RampForceCalculator(effect, elapsedTime);
+    break;
+  case USB_EFFECT_SQUARE:
+  case USB_EFFECT_SINE:
+  case USB_EFFECT_TRIANGLE:
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+    force = PeriodiceForceCalculator(effectType, effect, elapsedTime);
+    break;
+  case USB_EFFECT_CUSTOM:
+    force = CustomForceCalculator(effect, elapsedTime);
+    break;
+  case USB_EFFECT_WAVETABLE:
+    force = WavetableForceCalculator(effect, ffbReportHandler.GetWavetable(effectIdx), elapsedTime);
+    break;
+  default:
+    return 0;
+  }
+
+  if (effect.envelopeParameter)
+  {
+    const USB_FFBReport_SetEnvelope_Output_Data_t &envelope = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_2].envelope;
+    force *= GetEnvelope(envelope, elapsedTime, effect.block.duration);
+  }
+  return force;
+}
+
+void FfbEngine::AddEffectForce(const TEffectState &effect, uint64_t time, float forceSum[NUM_AXES]) const
+{
+  TEffectState modulatedEffect;
+  const TEffectState &played = GetModulatedEffect(effect, time, modulatedEffect);
+  uint8_t effectType = played.block.effectType;
+  float forceCondition[NUM_AXES] = {0};
+
+  switch (effectType)
+  {
+  case USB_EFFECT_CONSTANT:
+  case USB_EFFECT_RAMP:
+  case USB_EFFECT_SQUARE:
+  case USB_EFFECT_SINE:
+  case USB_EFFECT_TRIANGLE:
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+  case USB_EFFECT_CUSTOM:
+  case USB_EFFECT_WAVETABLE:
+    AddDirectedForce(played, TimeEffectForce(played, &effect - ffbReportHandler.GetEffectStates(), GetElapsedTime(played, time)), forceSum);
+    break;
+  case USB_EFFECT_SPRING:
+    ConditionForceCalculator(played, axisPosition.GetMetric(UserInput::position), forceCondition);
+    AddConditionForce(played, forceCondition, forceSum);
+    break;
+  case USB_EFFECT_FRICTION:
+  case USB_EFFECT_DAMPER:
+    ConditionForceCalculator(played, axisPosition.GetMetric(UserInput::speed), forceCondition);
+    AddConditionForce(played, forceCondition, forceSum);
+    break;
+  case USB_EFFECT_INERTIA:
+    ConditionForceCalculator(played, axisPosition.GetMetric(UserInput::acceleration), forceCondition);
+    AddConditionForce(played, forceCondition, forceSum);
+    break;
+  default:
     return;
   }
+}
+
+bool FfbEngine::IsModulationTarget(const TEffectState &effect) const
+{
+  uint8_t activeCount;
+  const TModulation *modulations = ffbReportHandler.GetModulations(activeCount);
+  if (activeCount == 0)
+    return false;
 
   const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+  if (&effect < effectStates || &effect >= effectStates + MAX_EFFECTS)
+    return false;
 
-  float forceSum[NUM_AXES] = {0};
-  uint64_t time = getTimeMilli();
+  uint8_t effectIdx = &effect - effectStates;
+  for (uint8_t slot = 0; slot < FFB_MAX_MODULATIONS; ++slot)
+  {
+    if (modulations[slot].destination != MODULATION_OFF && modulations[slot].targetIdx == effectIdx)
+      return true;
+  }
+  return false;
+}
 
-  for (uint8_t idx = 0; idx < MAX_EFFECTS; ++idx)
+const TEffectState &FfbEngine::GetModulatedEffect(const TEffectState &effect, uint64_t time, TEffectState &modulatedEffect) const
+{
+  if (!IsModulationTarget(effect))
+    return effect;
+
+  // custom forces find their samples by the effect's address, so only types with parameters to change are copied
+  switch (effect.block.effectType)
   {
-    const TEffectState &effect = effectStates[idx];
+  case USB_EFFECT_CONSTANT:
+  case USB_EFFECT_SQUARE:
+  case USB_EFFECT_SINE:
+  case USB_EFFECT_TRIANGLE:
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+  case USB_EFFECT_WAVETABLE:
+    break;
+  default:
+    return effect;
+  }
+
+  uint8_t activeCount;
+  const TModulation *modulations = ffbReportHandler.GetModulations(activeCount);
+  const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+  uint8_t effectIdx = &effect - effectStates;
+
+  // the routes change a copy, the stored parameters stay as the host set them
+  modulatedEffect = effect;
+  TEffectParameter &parameters = modulatedEffect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1];
+  for (uint8_t slot = 0; slot < FFB_MAX_MODULATIONS; ++slot)
+  {
+    const TModulation &modulation = modulations[slot];
+    if (modulation.destination == MODULATION_OFF || modulation.targetIdx != effectIdx)
+      continue;
 
-    if (IsEffectPlaying(effect, time))
+    const TEffectState &source = effectStates[modulation.sourceIdx];
+    if (!IsEffectPlaying(source, time))
+      continue;
+
+    float amount = modulation.depth * TimeEffectForce(source, modulation.sourceIdx, GetElapsedTime(source, time)) / USB_MAX_MAGNITUDE;
+    switch (modulatedEffect.block.effectType)
     {
-      uint8_t effectType = effect.block.effectType;
-      uint16_t duration = effect.block.duration;
-      uint32_t elapsedTime = time - effect.startTime;
-      uint8_t gain = effect.block.gain;
+    case USB_EFFECT_CONSTANT:
+      if (modulation.destination == MODULATION_MAGNITUDE)
+        parameters.constant.magnitude = ClampParameter(parameters.constant.magnitude + amount, -USB_MAX_MAGNITUDE, USB_MAX_MAGNITUDE);
+      break;
+    case USB_EFFECT_SQUARE:
+    case USB_EFFECT_SINE:
+    case USB_EFFECT_TRIANGLE:
+    case USB_EFFECT_SAWTOOTHDOWN:
+    case USB_EFFECT_SAWTOOTHUP:
+    case USB_EFFECT_WAVETABLE:
+      if (modulation.destination == MODULATION_MAGNITUDE)
+        parameters.periodic.magnitude = ClampParameter(parameters.periodic.magnitude + amount, 0, USB_MAX_MAGNITUDE);
+      else if (modulation.destination == MODULATION_OFFSET)
+        parameters.periodic.offset = ClampParameter(parameters.periodic.offset + amount, -USB_MAX_MAGNITUDE, USB_MAX_MAGNITUDE);
+      else if (modulation.destination == MODULATION_PERIOD)
+        parameters.periodic.period = ClampParameter(parameters.periodic.period + amount, 1, INT16_MAX);
+      break;
+    }
+  }
+  return modulatedEffect;
+}
 
-      float force = 0;
-      float forceCondition[NUM_AXES] = {0};
+int16_t FfbEngine::ClampParameter(float value, int16_t min, int16_t max)
+{
+  if (value < min)
+    return min;
+  if (value > max)
+    return max;
+  return (int16_t)lroundf(value);
+}
+
+void FfbEngine::AddDirectedForce(const TEffectState &effect, float force, float forceSum[NUM_AXES]) const
+{
+  force *= effect.block.gain;
+  force /= USB_MAX_GAIN;
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    if (effect.block.enableAxis >> i & 0x01)
+    {
+      float axisForce = force * effect.directionUnitVec[i];
+
+      if (forceHook != nullptr)
+        axisForce = forceHook(axisForce, effect.block.effectType, i);
+
+      forceSum[i] += axisForce;
+    }
+  }
+}
+
+void FfbEngine::AddConditionForce(const TEffectState &effect, float forceCondition[NUM_AXES], float forceSum[NUM_AXES]) const
+{
+  float force = 0;
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    forceCondition[i] *= effect.block.gain;
+    forceCondition[i] /= USB_MAX_GAIN;
+
+    if (forceHook != nullptr)
+      force = forceHook(force, effect.block.effectType, i);
+
+    forceSum[i] += forceCondition[i];
+  }
+}
+
+void FfbEngine::SumEffects(uint64_t time, const uint8_t *effects, uint8_t count, float forceSum[NUM_AXES], TForceCache *cache, uint8_t groups) const
+{
+  const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+
+  for (uint8_t idx = 0; idx < count; ++idx)
+  {
+    uint8_t effectIdx = effects[idx];
+    if (!(GetEffectGroup(effectStates[effectIdx]) & groups))
+      continue;
 
-      switch (effectType)
+    if (cache == nullptr)
+    {
+      AddEffectForce(effectStates[effectIdx], time, forceSum);
+      continue;
+    }
+
+    // 0 + force is exact, so a cached contribution adds up to the same sum as the direct evaluation
+    float *effectForce = cache->effectForces[effectIdx];
+    if (time >= cache->effectValidUntil[effectIdx])
+    {
+      for (uint8_t i = 0; i < NUM_AXES; ++i)
       {
-      case USB_EFFECT_CONSTANT:
-        force = ConstantForceCalculator(effect);
-        break;
-      case USB_EFFECT_RAMP:
-        force = RampForceCalculator(effect, elapsedTime);
-        break;
-      case USB_EFFECT_SQUARE:
-      case USB_EFFECT_SINE:
-      case USB_EFFECT_TRIANGLE:
-      case USB_EFFECT_SAWTOOTHDOWN:
-      case USB_EFFECT_SAWTOOTHUP:
-        force = PeriodiceForceCalculator(effectType, effect, elapsedTime);
-        break;
-      case USB_EFFECT_SPRING:
-        ConditionForceCalculator(effect, axisPosition.GetMetric(UserInput::position), forceCondition);
-        break;
-      case USB_EFFECT_FRICTION:
-      case USB_EFFECT_DAMPER:
-        ConditionForceCalculator(effect, axisPosition.GetMetric(UserInput::speed), forceCondition);
-        break;
-      case USB_EFFECT_INERTIA:
-        ConditionForceCalculator(effect, axisPosition.GetMetric(UserInput::acceleration), forceCondition);
-        break;
-      case USB_EFFECT_CUSTOM:
-      default:
-        continue;
+        effectForce[i] = 0;
       }
+      AddEffectForce(effectStates[effectIdx], time, effectForce);
+      uint64_t validUntil = GetValidUntil(effectStates[effectIdx], time);
+      // time based effects are held for at least one render period
+      if (validUntil < time + renderPeriod)
+        validUntil = time + renderPeriod;
+      cache->effectValidUntil[effectIdx] = validUntil;
+    }
 
-      switch (effectType)
-      {
-      case USB_EFFECT_CONSTANT:
-      case USB_EFFECT_RAMP:
-      case USB_EFFECT_SQUARE:
-      case USB_EFFECT_SINE:
-      case USB_EFFECT_TRIANGLE:
-      case USB_EFFECT_SAWTOOTHDOWN:
-      case USB_EFFECT_SAWTOOTHUP:
-        if (effect.envelopeParameter)
-        {
-          const USB_FFBReport_SetEnvelope_Output_Data_t &envelope = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_2].envelope;
-          force *= GetEnvelope(envelope, elapsedTime, duration);
-        }
-        force *= gain;
-        force /= USB_MAX_GAIN;
-        for (uint8_t i = 0; i < NUM_AXES; ++i)
-        {
-          if (effect.block.enableAxis >> i & 0x01)
-          {
-            force *= effect.directionUnitVec[i];
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      forceSum[i] += effectForce[i];
+    }
+  }
+}
 
-            if (forceHook != nullptr)
-              force = forceHook(force, effectType, i);
+void FfbEngine::SumEffectsChunk(void *context, uint32_t chunk)
+{
+  TChunkJob *chunkJob = (TChunkJob *)context;
+  uint8_t first = chunk * FFB_EFFECT_CHUNK_SIZE;
+  uint8_t count = (chunkJob->count - first < FFB_EFFECT_CHUNK_SIZE) ? chunkJob->count - first : FFB_EFFECT_CHUNK_SIZE;
+  chunkJob->engine->SumEffects(chunkJob->time, chunkJob->effects + first, count, chunkJob->chunkSums[chunk], chunkJob->cache, chunkJob->groups);
+}
 
-            forceSum[i] += force;
-          }
-        }
-        break;
-      case USB_EFFECT_SPRING:
-      case USB_EFFECT_FRICTION:
-      case USB_EFFECT_DAMPER:
-      case USB_EFFECT_INERTIA:
-        for (uint8_t i = 0; i < NUM_AXES; ++i)
-        {
-          forceCondition[i] *= gain;
-          forceCondition[i] /= USB_MAX_GAIN;
+void FfbEngine::SetParallelEvaluation(FfbParallelFor pFor, void *runner, uint8_t threshold)
+{
+  parallelFor = pFor;
+  parallelRunner = runner;
+  parallelThreshold = threshold;
+}
 
-          if (forceHook != nullptr)
-            force = forceHook(force, effectType, i);
+void FfbEngine::Evaluate(uint64_t deviceTime, int32_t ffbForce[NUM_AXES]) const
+{
+  float forceSum[NUM_AXES] = {0};
+  if (!ffbReportHandler.devicePaused)
+  {
+    EvaluateSum(ffbReportHandler.GetEffectTime(deviceTime), forceSum);
+    ffbReportHandler.AddStreamForce(deviceTime, forceSum);
+  }
 
-          forceSum[i] += forceCondition[i];
-        }
-        break;
-      case USB_EFFECT_CUSTOM:
-      default:
-        continue;
-      }
+  ApplyDeviceGain(forceSum, ffbForce);
+}
+
+void FfbEngine::EvaluateSum(uint64_t time, float forceSum[NUM_AXES], TForceCache *cache, uint8_t groups) const
+{
+  uint8_t activeCount;
+  const uint8_t *activeEffects;
+
+  // curves built by the last Advance are out of date once a report changed the effects
+  bool useCurves = conditionCurves.valid && conditionCurves.revision == ffbReportHandler.GetRevision();
+  if (useCurves)
+  {
+    activeEffects = conditionCurves.remainingEffects;
+    activeCount = conditionCurves.remainingCount;
+  }
+  else
+  {
+    activeEffects = ffbReportHandler.GetActiveEffects(activeCount);
+  }
+
+  // Effects are summed in fixed chunks and the chunk sums are added in order,
+  // so the result does not depend on whether the chunks ran in parallel.
+  uint8_t chunkCount = (activeCount + FFB_EFFECT_CHUNK_SIZE - 1) / FFB_EFFECT_CHUNK_SIZE;
+  float chunkSums[FFB_EFFECT_CHUNKS][NUM_AXES] = {{0}};
+
+  if (parallelFor != nullptr && activeCount >= parallelThreshold)
+  {
+    TChunkJob chunkJob = {this, time, activeEffects, activeCount, chunkSums, cache, groups};
+    parallelFor(parallelRunner, SumEffectsChunk, &chunkJob, chunkCount);
+  }
+  else
+  {
+    for (uint8_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+      uint8_t first = chunk * FFB_EFFECT_CHUNK_SIZE;
+      uint8_t count = (activeCount - first < FFB_EFFECT_CHUNK_SIZE) ? activeCount - first : FFB_EFFECT_CHUNK_SIZE;
+      SumEffects(time, activeEffects + first, count, chunkSums[chunk], cache, groups);
     }
   }
 
+  for (uint8_t chunk = 0; chunk < chunkCount; ++chunk)
+  {
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      forceSum[i] += chunkSums[chunk][i];
+    }
+  }
+
+  if (cache != nullptr)
+  {
+    const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+    for (uint8_t idx = 0; idx < activeCount; ++idx)
+    {
+      uint8_t effectIdx = activeEffects[idx];
+      if ((GetEffectGroup(effectStates[effectIdx]) & groups) && cache->effectValidUntil[effectIdx] < cache->validUntil)
+        cache->validUntil = cache->effectValidUntil[effectIdx];
+    }
+  }
+
+  if (!useCurves || !(groups & conditionEffects))
+    return;
+
+  for (uint8_t metric = 0; metric < UserInput::metricsCount; ++metric)
+  {
+    if (!conditionCurves.merged[metric])
+      continue;
+
+    const int32_t *metricValues = axisPosition.GetMetric((UserInput::Metric)metric);
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      forceSum[i] += conditionCurves.curves[metric][i].Evaluate(metricValues[i]);
+    }
+  }
+}
+
+void FfbEngine::ApplyDeviceGain(const float forceSum[NUM_AXES], int32_t ffbForce[NUM_AXES]) const
+{
   for (uint8_t i = 0; i < NUM_AXES; ++i)
   {
-    forceSum[i] *= ffbReportHandler.deviceGain;
-    forceSum[i] /= USB_MAX_GAIN;
+    float force = forceSum[i];
+    force *= ffbReportHandler.deviceGain;
+    force /= USB_MAX_GAIN;
+
+    ffbForce[i] = force;
+  }
+}
+
+uint64_t FfbEngine::GetValidUntil(const TEffectState &effect, uint64_t time) const
+{
+  uint8_t effectType = effect.block.effectType;
+  uint32_t elapsedTime = GetElapsedTime(effect, time);
+  // time has millisecond resolution, so any effect is constant within the same millisecond
+  uint64_t validUntil = time + 1;
+  if (IsModulationTarget(effect))
+    return validUntil;
 
-    ffbForce[i] = forceSum[i];
+  switch (effectType)
+  {
+  case USB_EFFECT_SPRING:
+  case USB_EFFECT_FRICTION:
+  case USB_EFFECT_DAMPER:
+  case USB_EFFECT_INERTIA:
+    // conditions only change with the inputs
+    return FFB_TIME_NEVER;
+  case USB_EFFECT_CONSTANT:
+    validUntil = FFB_TIME_NEVER;
+    break;
+  case USB_EFFECT_SQUARE:
+  {
+    // same edges as PeriodiceForceCalculator
+    const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+    uint32_t period = periodic.period;
+    if (period == 0)
+      return validUntil;
+    float phaseNormalized = (float)periodic.phase / USB_MAX_PHASE;
+    uint32_t elapsedPlusPhaseTime = phaseNormalized * period + (float)elapsedTime;
+    uint32_t remainder = elapsedPlusPhaseTime % period;
+    uint32_t nextEdge = (remainder < period / 2) ? period / 2 : period;
+    validUntil = time + (nextEdge - remainder);
   }
+  break;
+  default:
+    return validUntil;
+  }
+
+  if (!effect.envelopeParameter)
+    return validUntil;
+
+  // the envelope is flat between the end of the attack and the start of the fade, see GetEnvelope
+  const USB_FFBReport_SetEnvelope_Output_Data_t &envelope = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_2].envelope;
+  uint32_t attackTime = envelope.attackTime;
+  uint32_t fadeTime = envelope.fadeTime;
+  uint32_t duration = effect.block.duration;
+
+  if (elapsedTime < attackTime)
+    return time + 1;
+  if (duration == USB_DURATION_INFINITE)
+    return validUntil;
+  // a fade longer than the effect covers all of it, as in GetEnvelope
+  if (fadeTime >= duration || elapsedTime >= duration - fadeTime)
+    return time + 1;
+
+  uint64_t fadeStart = time + ((duration - fadeTime) - elapsedTime);
+  return fadeStart < validUntil ? fadeStart : validUntil;
 }
 
-float FfbEngine::GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &envelope, uint32_t elapsedTime, uint16_t duration)
+float FfbEngine::GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &envelope, float elapsedTime, uint16_t duration) const
 {
   int32_t attackLevel = envelope.attackLevel;
   int32_t fadeLevel = envelope.fadeLevel;
@@ -319,7 +806,8 @@ float FfbEngine::GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &enve
     return 1.0;
   }
 
-  if (elapsedTime >= (duration - fadeTime))
+  int32_t fadeStart = duration - fadeTime;
+  if (fadeStart >= 0 && elapsedTime >= fadeStart)
   {
     float height = (USB_MAX_MAGNITUDE - fadeLevel);
     float slope = height / fadeTime;
@@ -330,54 +818,398 @@ float FfbEngine::GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &enve
   return 1.0;
 }
 
-bool IsTriggerEffectPlaying(TEffectState &effect, uint8_t buttonState, uint64_t time)
+void FfbEngine::ForceAverage(uint64_t deviceTimeStart, uint64_t deviceTimeEnd, int32_t ffbForce[NUM_AXES]) const
 {
-  int64_t elapsedTime = time - effect.startTime;
-  uint8_t buttonIdx = effect.block.triggerButton - 1;
-  bool buttonPressed = ((buttonState >> buttonIdx) & 0x01);
-  if (!buttonPressed)
+  if (deviceTimeEnd <= deviceTimeStart)
   {
-    effect.triggerButtonLatch = false;
-    return false;
+    Evaluate(deviceTimeStart, ffbForce);
+    return;
   }
-  else
+
+  float forceSum[NUM_AXES] = {0};
+  if (ffbReportHandler.devicePaused)
   {
-    if (!effect.triggerButtonLatch)
+    ApplyDeviceGain(forceSum, ffbForce);
+    return;
+  }
+
+  uint64_t start = ffbReportHandler.GetEffectTime(deviceTimeStart);
+  uint64_t end = start + (deviceTimeEnd - deviceTimeStart);
+  double length = end - start;
+  const TEffectState *effectStates = ffbReportHandler.GetEffectStates();
+
+  for (uint8_t idx = 0; idx < MAX_EFFECTS; ++idx)
+  {
+    const TEffectState &effect = effectStates[idx];
+    uint8_t effectType = effect.block.effectType;
+    if (!(effect.state & MEFFECTSTATE_PLAYING) || effectType < USB_EFFECT_CONSTANT || effectType > USB_EFFECT_WAVETABLE)
+      continue;
+
+    bool triggerEffect = effect.block.triggerButton != USB_NO_TRIGGER_BUTTON;
+    if (triggerEffect && !effect.triggerButtonLatch)
+      continue;
+
+    // effect plays in [windowStart, windowStart + duration), trigger effects repeat the window every period
+    uint16_t duration = effect.block.duration;
+    bool infinite = duration == USB_DURATION_INFINITE;
+    uint32_t period = 0;
+    if (triggerEffect && !infinite)
+      period = duration + effect.block.triggerRepeatInterval;
+
+    uint64_t windowStart = effect.startTime;
+    if (period != 0 && start > windowStart)
+      windowStart += (start - windowStart) / period * period;
+
+    bool condition = GetConditionMetric(effectType) >= 0;
+    bool modulated = IsModulationTarget(effect);
+    double playTime = 0;
+    double integral = 0;
+    while (windowStart < end)
     {
-      effect.startTime = time;
-      effect.triggerButtonLatch = true;
-      return true;
+      uint64_t playStart = start > windowStart ? start : windowStart;
+      uint64_t playEnd = (infinite || windowStart + duration > end) ? end : windowStart + duration;
+      if (playStart < playEnd)
+      {
+        playTime += playEnd - playStart;
+        if (!condition && modulated)
+        {
+          // the routes change the parameters every millisecond, like the sampled force
+          for (uint64_t time = playStart; time < playEnd; ++time)
+          {
+            TEffectState modulatedEffect;
+            const TEffectState &played = GetModulatedEffect(effect, time, modulatedEffect);
+            integral += IntegrateEffect(played, idx, time - windowStart, time + 1 - windowStart);
+          }
+        }
+        else if (!condition)
+          integral += IntegrateEffect(effect, idx, playStart - windowStart, playEnd - windowStart);
+      }
+
+      if (period == 0)
+        break;
+      windowStart += period;
+    }
+
+    if (playTime == 0)
+      continue;
+
+    if (condition)
+    {
+      // conditions only depend on the inputs, they count for the part of the interval they play
+      float forceCondition[NUM_AXES] = {0};
+      ConditionForceCalculator(effect, axisPosition.GetMetric((UserInput::Metric)GetConditionMetric(effectType)), forceCondition);
+      for (uint8_t i = 0; i < NUM_AXES; ++i)
+      {
+        forceCondition[i] *= playTime / length;
+      }
+      AddConditionForce(effect, forceCondition, forceSum);
     }
     else
     {
-      if (elapsedTime < effect.block.duration)
-        return true;
+      AddDirectedForce(effect, integral / length, forceSum);
+    }
+  }
 
-      if (elapsedTime < (effect.block.duration + effect.block.triggerRepeatInterval))
-        return false;
+  // the stream holds each sample, the newest one stands for the interval
+  ffbReportHandler.AddStreamForce(deviceTimeEnd, forceSum);
+  ApplyDeviceGain(forceSum, ffbForce);
+}
 
-      effect.startTime = time;
-      return true;
+double FfbEngine::IntegrateEffect(const TEffectState &effect, uint8_t effectIdx, double elapsedStart, double elapsedEnd) const
+{
+  double integral = 0;
+  for (double a = elapsedStart; a < elapsedEnd;)
+  {
+    double b = GetNextBreakpoint(effect, effectIdx, a);
+    if (b > elapsedEnd)
+      b = elapsedEnd;
+    integral += IntegratePiece(effect, effectIdx, a, b);
+    a = b;
+  }
+  return integral;
+}
+
+double FfbEngine::GetNextBreakpoint(const TEffectState &effect, uint8_t effectIdx, double elapsedTime) const
+{
+  // distances below this are the breakpoint elapsedTime itself
+  const double epsilon = 1e-9;
+  double next = HUGE_VAL;
+
+  if (effect.envelopeParameter)
+  {
+    const USB_FFBReport_SetEnvelope_Output_Data_t &envelope = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_2].envelope;
+    double attackEnd = envelope.attackTime;
+    double fadeStart = (int32_t)effect.block.duration - (int32_t)envelope.fadeTime;
+    if (attackEnd > elapsedTime + epsilon && attackEnd < next)
+      next = attackEnd;
+    if (effect.block.duration != USB_DURATION_INFINITE && fadeStart > elapsedTime + epsilon && fadeStart < next)
+      next = fadeStart;
+  }
+
+  if (effect.block.effectType == USB_EFFECT_CUSTOM || effect.block.effectType == USB_EFFECT_WAVETABLE)
+  {
+    double value, slope;
+    double distance = GetTableSegment(effect, effectIdx, elapsedTime, value, slope);
+    if (distance <= epsilon)
+      distance += GetTableSegment(effect, effectIdx, elapsedTime + distance, value, slope);
+    if (elapsedTime + distance < next)
+      next = elapsedTime + distance;
+    return next;
+  }
+
+  const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+  uint32_t period = periodic.period;
+  uint32_t cycleBreaks[2];
+  uint8_t cycleBreakCount = 0;
+  switch (effect.block.effectType)
+  {
+  case USB_EFFECT_SQUARE:
+    cycleBreaks[cycleBreakCount++] = 0;
+    cycleBreaks[cycleBreakCount++] = period / 2;
+    break;
+  case USB_EFFECT_TRIANGLE:
+    cycleBreaks[cycleBreakCount++] = period / 2 - period / 4;
+    cycleBreaks[cycleBreakCount++] = period - period / 4;
+    break;
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+    cycleBreaks[cycleBreakCount++] = 0;
+    break;
+  default:
+    return next;
+  }
+  if (period == 0)
+    return next;
+
+  double cyclePosition = GetCyclePosition(periodic, elapsedTime);
+  for (uint8_t i = 0; i < cycleBreakCount; ++i)
+  {
+    double distance = cycleBreaks[i] - cyclePosition;
+    if (distance <= epsilon)
+      distance += period;
+    if (elapsedTime + distance < next)
+      next = elapsedTime + distance;
+  }
+  return next;
+}
+
+double FfbEngine::GetCyclePosition(const USB_FFBReport_SetPeriodic_Output_Data_t &periodic, double elapsedTime) const
+{
+  // same phase as PeriodiceForceCalculator, without rounding to whole milliseconds
+  float phaseNormalized = (float)periodic.phase / USB_MAX_PHASE;
+  return fmod(phaseNormalized * periodic.period + elapsedTime, periodic.period);
+}
+
+void FfbEngine::GetPeriodicSegment(uint8_t effectType, const USB_FFBReport_SetPeriodic_Output_Data_t &periodic, double cyclePosition, double &value, double &slope) const
+{
+  double offset = periodic.offset;
+  double magnitude = periodic.magnitude;
+  uint32_t period = periodic.period;
+
+  switch (effectType)
+  {
+  case USB_EFFECT_SQUARE:
+    value = (cyclePosition >= period / 2) ? -magnitude : magnitude;
+    slope = 0;
+    break;
+  case USB_EFFECT_TRIANGLE:
+  {
+    double triangleSlope = 4 * magnitude / period;
+    double offsetPosition = cyclePosition + period / 4;
+    if (offsetPosition >= period)
+      offsetPosition -= period;
+    if (offsetPosition >= period / 2)
+    {
+      value = triangleSlope * (period - offsetPosition);
+      slope = -triangleSlope;
+    }
+    else
+    {
+      value = triangleSlope * offsetPosition;
+      slope = triangleSlope;
     }
+    value -= magnitude;
   }
+  break;
+  case USB_EFFECT_SAWTOOTHDOWN:
+    value = magnitude / period * (period - cyclePosition);
+    slope = -magnitude / period;
+    break;
+  case USB_EFFECT_SAWTOOTHUP:
+    value = magnitude / period * cyclePosition;
+    slope = magnitude / period;
+    break;
+  default:
+    value = 0;
+    slope = 0;
+    return;
+  }
+  value += offset;
 }
 
-bool FfbEngine::IsEffectPlaying(const TEffectState &effect, uint64_t time)
+double FfbEngine::GetTableSegment(const TEffectState &effect, uint8_t effectIdx, double elapsedTime, double &value, double &slope) const
 {
-  if (!(effect.state & MEFFECTSTATE_PLAYING))
-    return false;
+  double pointTime, position, scale;
+  const int8_t *samples = nullptr;
+  const int16_t *points = nullptr;
+  uint16_t count = 0;
+  value = 0;
+  slope = 0;
+
+  if (effect.block.effectType == USB_EFFECT_CUSTOM)
+  {
+    // same samples and timing as CustomForceCalculator
+    const TCustomForce *customForce = ffbReportHandler.GetCustomForce(effectIdx);
+    if (customForce == nullptr)
+      return HUGE_VAL;
+    count = customForce->sampleCount != 0 ? customForce->sampleCount : customForce->writtenCount;
+    uint16_t samplePeriod = customForce->samplePeriod;
+    if (samplePeriod == 0)
+      samplePeriod = effect.block.samplePeriod;
+    if (samplePeriod == 0)
+      samplePeriod = 1;
+    samples = customForce->samples;
+    pointTime = samplePeriod;
+    position = elapsedTime / samplePeriod;
+    scale = (double)USB_MAX_MAGNITUDE / USB_MAX_CUSTOM_SAMPLE;
+  }
+  else
+  {
+    // same points and phase as WavetableForceCalculator
+    const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+    const TWavetable *wavetable = ffbReportHandler.GetWavetable(effectIdx);
+    value = periodic.offset;
+    if (wavetable == nullptr || periodic.period == 0)
+      return HUGE_VAL;
+    count = wavetable->pointCount;
+    points = wavetable->points;
+    pointTime = (double)periodic.period / count;
+    position = GetCyclePosition(periodic, elapsedTime) / pointTime;
+    scale = (double)periodic.magnitude / USB_MAX_WAVETABLE_POINT;
+  }
+  if (count == 0)
+    return HUGE_VAL;
+
+  uint32_t point = position;
+  double fraction = position - point;
+  point %= count;
+  uint16_t nextPoint = (point + 1) % count;
+  double point0 = samples ? samples[point] : points[point];
+  double point1 = samples ? samples[nextPoint] : points[nextPoint];
+
+  value += (point0 + (point1 - point0) * fraction) * scale;
+  slope = (point1 - point0) * scale / pointTime;
+  return (1 - fraction) * pointTime;
+}
 
-  if (effect.block.triggerButton != USB_NO_TRIGGER_BUTTON)
+double FfbEngine::IntegratePiece(const TEffectState &effect, uint8_t effectIdx, double a, double b) const
+{
+  uint8_t effectType = effect.block.effectType;
+  double middle = (a + b) / 2;
+
+  // the envelope is linear between breakpoints
+  double envelopeA = 1, envelopeM = 1, envelopeB = 1;
+  if (effect.envelopeParameter)
+  {
+    const USB_FFBReport_SetEnvelope_Output_Data_t &envelope = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_2].envelope;
+    envelopeA = GetEnvelope(envelope, a, effect.block.duration);
+    envelopeM = GetEnvelope(envelope, middle, effect.block.duration);
+    envelopeB = GetEnvelope(envelope, b, effect.block.duration);
+  }
+
+  double forceA, forceM, forceB;
+  switch (effectType)
+  {
+  case USB_EFFECT_CONSTANT:
+    forceA = forceM = forceB = ConstantForceCalculator(effect);
+    break;
+  case USB_EFFECT_RAMP:
+    forceA = RampForceCalculator(effect, a);
+    forceM = RampForceCalculator(effect, middle);
+    forceB = RampForceCalculator(effect, b);
+    break;
+  case USB_EFFECT_SQUARE:
+  case USB_EFFECT_TRIANGLE:
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+  {
+    // the wave may jump at a and b, so both ends come from the line through the middle
+    const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+    if (periodic.period == 0)
+      return 0;
+    double slope;
+    GetPeriodicSegment(effectType, periodic, GetCyclePosition(periodic, middle), forceM, slope);
+    forceA = forceM - slope * (middle - a);
+    forceB = forceM + slope * (b - middle);
+  }
+  break;
+  case USB_EFFECT_CUSTOM:
+  case USB_EFFECT_WAVETABLE:
   {
-    return IsTriggerEffectPlaying(const_cast<TEffectState &>(effect), axisPosition.GetButtons(), time);
+    // linear between table points, the pieces end at the points
+    double slope;
+    GetTableSegment(effect, effectIdx, middle, forceM, slope);
+    forceA = forceM - slope * (middle - a);
+    forceB = forceM + slope * (b - middle);
   }
+  break;
+  case USB_EFFECT_SINE:
+  {
+    // integral of (alpha + beta (x - a)) (magnitude sin(omega x + phi) + offset) over [a, b)
+    const USB_FFBReport_SetPeriodic_Output_Data_t &periodic = effect.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1].periodic;
+    if (periodic.period == 0)
+      return 0;
+    double omega = 2 * M_PI / periodic.period;
+    double phi = 2 * M_PI * ((double)periodic.phase / USB_MAX_PHASE);
+    double alpha = envelopeA;
+    double beta = (envelopeB - envelopeA) / (b - a);
+
+    double angleA = omega * a + phi;
+    double angleB = omega * b + phi;
+    double waveIntegral = -(alpha + beta * (b - a)) * cos(angleB) / omega + beta * sin(angleB) / (omega * omega);
+    waveIntegral -= -alpha * cos(angleA) / omega + beta * sin(angleA) / (omega * omega);
+
+    return periodic.magnitude * waveIntegral + periodic.offset * (envelopeA + envelopeB) / 2 * (b - a);
+  }
+  default:
+    return 0;
+  }
+
+  // Simpson's rule is exact for the product of two linear functions
+  return (b - a) / 6 * (envelopeA * forceA + 4 * envelopeM * forceM + envelopeB * forceB);
+}
+
+bool FfbEngine::IsEffectPlaying(const TEffectState &effect, uint64_t time) const
+{
+  if (!(effect.state & MEFFECTSTATE_PLAYING))
+    return false;
+
+  bool triggerEffect = effect.block.triggerButton != USB_NO_TRIGGER_BUTTON;
+  if (triggerEffect && !effect.triggerButtonLatch)
+    return false;
 
   int64_t elapsedTime = time - effect.startTime;
   if (elapsedTime < 0)
     return false;
 
-  if ((effect.block.duration != USB_DURATION_INFINITE) && (elapsedTime >= effect.block.duration))
-    return false;
+  if (effect.block.duration == USB_DURATION_INFINITE)
+    return true;
+
+  if (triggerEffect)
+    elapsedTime = GetElapsedTime(effect, time);
+
+  return elapsedTime < effect.block.duration;
+}
+
+uint32_t FfbEngine::GetElapsedTime(const TEffectState &effect, uint64_t time) const
+{
+  uint64_t elapsedTime = time - effect.startTime;
+  if (effect.block.triggerButton == USB_NO_TRIGGER_BUTTON || effect.block.duration == USB_DURATION_INFINITE)
+    return elapsedTime;
 
-  return true;
+  // trigger effects repeat every duration + repeat interval since the button press
+  uint32_t period = effect.block.duration + effect.block.triggerRepeatInterval;
+  if (period == 0)
+    return elapsedTime;
+  return elapsedTime % period;
 }
@@ -26,26 +26,141 @@
 #include "HIDReportType.h"
 #include "FfbReportHandler.h"
 #include "UserInput.h"
+#include "FfbConditionCurve.h"
+
+// Active effects are summed in chunks of this size, a chunk is the unit of parallel evaluation
+#define FFB_EFFECT_CHUNK_SIZE 8
+#define FFB_EFFECT_CHUNKS ((MAX_EFFECTS + FFB_EFFECT_CHUNK_SIZE - 1) / FFB_EFFECT_CHUNK_SIZE)
+
+// Calls job(context, i) for every i < jobCount, possibly in parallel, and returns when all of them finished
+typedef void (*FfbParallelFor)(void *runner, void (*job)(void *context, uint32_t jobIdx), void *context, uint32_t jobCount);
 
 class FfbEngine
 {
 public:
-  FfbEngine(FfbReportHandler &reporthandler, UserInput &uIn, uint64_t (*)(void), int32_t (*)(float, int8_t, int8_t) = nullptr);
+  FfbEngine(FfbReportHandler &reporthandler, UserInput &uIn, uint64_t (*)(void) = nullptr, int32_t (*)(float, int8_t, int8_t) = nullptr);
   ~FfbEngine();
 
+  // Without a clock callback it uses the time of the last Advance
   void ForceCalculator(int32_t[NUM_AXES]);
-  float ConstantForceCalculator(const TEffectState &effect);
-  float RampForceCalculator(const TEffectState &effect, float elapsedTime);
-  void ConditionForceCalculator(const TEffectState &effect, const int32_t metric[NUM_AXES], float outForce[NUM_AXES]);
-  float PeriodiceForceCalculator(uint8_t effectType, const TEffectState &effect, float elapsedTime);
-  float GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &effect, uint32_t elapsedTime, uint16_t duration);
-  bool IsEffectPlaying(const TEffectState &effect, uint64_t time);
+  // Same as above, but with the device time supplied by the caller instead of read from the clock callback
+  void ForceCalculator(uint64_t time, int32_t[NUM_AXES]);
+
+  // ForceCalculator split in two phases. Advance applies pending and timed reports, timeline steps, time and button
+  // transitions to the effect states. Evaluate only reads them, so it can be repeated, run speculatively or from
+  // several threads.
+  // Evaluate does not start or stop effects, times past the last Advance see the same active effects.
+  void Advance(uint64_t time);
+  void Evaluate(uint64_t time, int32_t[NUM_AXES]) const;
+  // Average force over [timeStart, timeEnd) for outputs slower than the effect content. Effects are integrated in
+  // closed form instead of sampled. Like Evaluate it reads the effect states without advancing them.
+  void ForceAverage(uint64_t timeStart, uint64_t timeEnd, int32_t[NUM_AXES]) const;
+  // Evaluate chunks of active effects through parallelFor when at least threshold effects are active.
+  // The result is identical to the serial path. forceHook must be thread safe when this is enabled.
+  void SetParallelEvaluation(FfbParallelFor parallelFor, void *runner, uint8_t threshold);
+  // Multi-rate mode for ForceCalculator: time based effects are evaluated at most every period ms of effect time and
+  // held in between, while conditions follow every input update. 1 (default) evaluates them every millisecond.
+  void SetRenderPeriod(uint16_t period);
+
+  float ConstantForceCalculator(const TEffectState &effect) const;
+  float RampForceCalculator(const TEffectState &effect, float elapsedTime) const;
+  void ConditionForceCalculator(const TEffectState &effect, const int32_t metric[NUM_AXES], float outForce[NUM_AXES]) const;
+  float PeriodiceForceCalculator(uint8_t effectType, const TEffectState &effect, float elapsedTime) const;
+  float CustomForceCalculator(const TEffectState &effect, float elapsedTime) const;
+  float WavetableForceCalculator(const TEffectState &effect, const TWavetable *wavetable, float elapsedTime) const;
+  float GetEnvelope(const USB_FFBReport_SetEnvelope_Output_Data_t &effect, float elapsedTime, uint16_t duration) const;
+  // force of a time based effect with its envelope, before gain and direction, effectIdx finds uploaded wavetables
+  float TimeEffectForce(const TEffectState &effect, uint8_t effectIdx, uint32_t elapsedTime) const;
+  bool IsEffectPlaying(const TEffectState &effect, uint64_t time) const;
+  // effect time until which the effect's force stays what it is at time, conditions also depend on the inputs
+  uint64_t GetValidUntil(const TEffectState &effect, uint64_t time) const;
+  uint32_t GetElapsedTime(const TEffectState &effect, uint64_t time) const;
 
 private:
+  enum EffectGroup
+  {
+    timeEffects = 0x01,
+    conditionEffects = 0x02,
+    allEffects = timeEffects | conditionEffects
+  };
+
+  // forces of the last ForceCalculator call, before device gain
+  typedef struct
+  {
+    bool valid = false;
+    uint32_t reportRevision;
+    uint32_t inputRevision;
+    uint64_t time;
+    // earliest effectValidUntil of the time based effects
+    uint64_t validUntil;
+    float timeForceSum[NUM_AXES];
+    float conditionForceSum[NUM_AXES];
+    uint64_t effectValidUntil[MAX_EFFECTS];
+    float effectForces[MAX_EFFECTS][NUM_AXES];
+  } TForceCache;
+
+  typedef struct
+  {
+    const FfbEngine *engine;
+    uint64_t time;
+    const uint8_t *effects;
+    uint8_t count;
+    float (*chunkSums)[NUM_AXES];
+    TForceCache *cache;
+    uint8_t groups;
+  } TChunkJob;
+
+  static uint8_t GetEffectGroup(const TEffectState &effect);
+  static int8_t GetConditionMetric(uint8_t effectType);
+  void BuildConditionCurves();
+  // response curve of a condition block, only the handler's effect states can have them
+  const TResponseCurve *GetResponseCurve(const TEffectState &effect, uint8_t parameterBlockOffset) const;
+  void EvaluateSum(uint64_t time, float forceSum[NUM_AXES], TForceCache *cache = nullptr, uint8_t groups = allEffects) const;
+  void ApplyDeviceGain(const float forceSum[NUM_AXES], int32_t ffbForce[NUM_AXES]) const;
+  void AddEffectForce(const TEffectState &effect, uint64_t time, float forceSum[NUM_AXES]) const;
+  // only the handler's effect states can be targets
+  bool IsModulationTarget(const TEffectState &effect) const;
+  // effect with the parameters its modulation routes give it at time, modulatedEffect holds them if there are any
+  const TEffectState &GetModulatedEffect(const TEffectState &effect, uint64_t time, TEffectState &modulatedEffect) const;
+  static int16_t ClampParameter(float value, int16_t min, int16_t max);
+  void AddDirectedForce(const TEffectState &effect, float force, float forceSum[NUM_AXES]) const;
+  void AddConditionForce(const TEffectState &effect, float forceCondition[NUM_AXES], float forceSum[NUM_AXES]) const;
+  // integral of the effect force before gain over elapsed time [elapsedStart, elapsedEnd) of one play window,
+  // effectIdx finds the uploaded tables of modulated copies
+  double IntegrateEffect(const TEffectState &effect, uint8_t effectIdx, double elapsedStart, double elapsedEnd) const;
+  // next elapsed time where the envelope or the wave changes its slope or jumps
+  double GetNextBreakpoint(const TEffectState &effect, uint8_t effectIdx, double elapsedTime) const;
+  double GetCyclePosition(const USB_FFBReport_SetPeriodic_Output_Data_t &periodic, double elapsedTime) const;
+  void GetPeriodicSegment(uint8_t effectType, const USB_FFBReport_SetPeriodic_Output_Data_t &periodic, double cyclePosition, double &value, double &slope) const;
+  // line between the custom force samples or wavetable points around elapsedTime, returns the time to the next point
+  double GetTableSegment(const TEffectState &effect, uint8_t effectIdx, double elapsedTime, double &value, double &slope) const;
+  double IntegratePiece(const TEffectState &effect, uint8_t effectIdx, double a, double b) const;
+  void SumEffects(uint64_t time, const uint8_t *effects, uint8_t count, float forceSum[NUM_AXES], TForceCache *cache, uint8_t groups) const;
+  static void SumEffectsChunk(void *context, uint32_t chunk);
+
   FfbReportHandler &ffbReportHandler;
   UserInput &axisPosition;
   uint64_t (*getTimeMilli)(void);
+  uint64_t lastTime = 0;
   int32_t (*forceHook)(float forceValue, int8_t effect, int8_t axisIndex);
+  FfbParallelFor parallelFor = nullptr;
+  void *parallelRunner = nullptr;
+  uint8_t parallelThreshold = 0;
+  uint16_t renderPeriod = 1;
+
+  // active conditions of each metric merged into one response per axis, rebuilt by Advance when the report revision changes
+  struct
+  {
+    bool valid = false;
+    uint32_t revision;
+    bool merged[UserInput::metricsCount];
+    FfbConditionCurve curves[UserInput::metricsCount][NUM_AXES];
+    // active effects that are not covered by the merged curves
+    uint8_t remainingEffects[MAX_EFFECTS];
+    uint8_t remainingCount;
+  } conditionCurves;
+
+  TForceCache forceCache;
 };
 
 #endif
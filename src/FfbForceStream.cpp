@@ -0,0 +1,103 @@
+/*
+  Force Feedback Joystick
+  Jitter buffer for directly streamed force samples.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+
+#include "FfbForceStream.h"
+
+FfbForceStream::FfbForceStream()
+{
+  Reset();
+}
+
+void FfbForceStream::Reset()
+{
+  head = 0;
+  count = 0;
+  lastArrival = 0;
+  arrivalInterval = 1;
+}
+
+void FfbForceStream::SetPlayout(uint16_t delay, uint16_t hold, uint16_t decay)
+{
+  playoutDelay = delay;
+  holdTime = hold;
+  decayTime = decay;
+}
+
+void FfbForceStream::Push(uint64_t time, int8_t x, int8_t y)
+{
+  uint64_t playoutTime = time + playoutDelay;
+  // after a pause in the stream the samples play at their own delay again, the pause is not an arrival interval
+  if (count > 0 && time - lastArrival <= FFB_FORCE_STREAM_MAX_INTERVAL)
+  {
+    // smoothed interval between samples
+    float interval = time - lastArrival;
+    arrivalInterval += (interval - arrivalInterval) / 8;
+
+    const TSample &previous = samples[(head + FFB_FORCE_STREAM_SIZE - 1) % FFB_FORCE_STREAM_SIZE];
+    uint64_t nextSlot = previous.playoutTime + (uint64_t)(arrivalInterval + 0.5f);
+    uint64_t latest = time + 2 * playoutDelay;
+    if (nextSlot > playoutTime)
+      playoutTime = nextSlot < latest ? nextSlot : latest;
+  }
+
+  TSample &sample = samples[head];
+  sample.playoutTime = playoutTime;
+  sample.x = x;
+  sample.y = y;
+  head = (head + 1) % FFB_FORCE_STREAM_SIZE;
+  if (count < FFB_FORCE_STREAM_SIZE)
+    ++count;
+  lastArrival = time;
+}
+
+bool FfbForceStream::AddForce(uint64_t time, float force[NUM_AXES]) const
+{
+  // newest sample that is due
+  const TSample *playing = nullptr;
+  for (uint8_t i = 1; i <= count; ++i)
+  {
+    const TSample &sample = samples[(head + FFB_FORCE_STREAM_SIZE - i) % FFB_FORCE_STREAM_SIZE];
+    if (sample.playoutTime <= time)
+    {
+      playing = &sample;
+      break;
+    }
+  }
+  if (playing == nullptr)
+    return false;
+
+  float scale = (float)USB_MAX_MAGNITUDE / USB_MAX_CUSTOM_SAMPLE;
+
+  // underrun, the next sample should have replaced this one by now
+  uint64_t nextDue = playing->playoutTime + (uint64_t)(arrivalInterval + 0.5f);
+  if (decayTime != FFB_FORCE_STREAM_DECAY_NEVER && time > nextDue + holdTime)
+  {
+    float decay = 1 - (float)(time - nextDue - holdTime) / decayTime;
+    scale *= decay > 0 ? decay : 0;
+  }
+
+  force[0] += playing->x * scale;
+  if (NUM_AXES > 1)
+    force[1] += playing->y * scale;
+  return true;
+}
@@ -0,0 +1,82 @@
+/*
+  Force Feedback Joystick
+  Jitter buffer for directly streamed force samples.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBFORCESTREAM_h
+#define FFBFORCESTREAM_h
+
+#include "HIDReportType.h"
+
+// Streamed samples kept for playout
+#ifndef FFB_FORCE_STREAM_SIZE
+#define FFB_FORCE_STREAM_SIZE 16
+#endif
+// Default ms the last sample is held after an underrun and then fades out over, so a host that stops streaming
+// does not leave the force on the motor
+#ifndef FFB_FORCE_STREAM_HOLD_TIME
+#define FFB_FORCE_STREAM_HOLD_TIME 20
+#endif
+#ifndef FFB_FORCE_STREAM_DECAY_TIME
+#define FFB_FORCE_STREAM_DECAY_TIME 50
+#endif
+// decayTime that holds the last sample until the next one arrives
+#define FFB_FORCE_STREAM_DECAY_NEVER 0
+// Longest gap between samples taken as the stream's arrival interval, a longer one starts a new burst
+#ifndef FFB_FORCE_STREAM_MAX_INTERVAL
+#define FFB_FORCE_STREAM_MAX_INTERVAL 32
+#endif
+
+// Download Force Sample reports carry a force per axis that bypasses effect management. Each sample is played
+// playoutDelay ms after it arrived. Samples arriving in bursts are spread out at the smoothed arrival interval, as
+// long as that keeps them within two playout delays of their arrival.
+class FfbForceStream
+{
+public:
+  FfbForceStream();
+
+  void Reset();
+  // holdTime ms after the next sample was due the last one starts to fade out over decayTime ms.
+  // FFB_FORCE_STREAM_DECAY_NEVER holds it.
+  void SetPlayout(uint16_t delay, uint16_t holdTime, uint16_t decayTime);
+  void Push(uint64_t time, int8_t x, int8_t y);
+  // adds the force playing at time, returns false when no sample is playing yet
+  bool AddForce(uint64_t time, float force[NUM_AXES]) const;
+
+private:
+  typedef struct
+  {
+    uint64_t playoutTime;
+    int8_t x;
+    int8_t y;
+  } TSample;
+
+  TSample samples[FFB_FORCE_STREAM_SIZE];
+  uint8_t head; // next sample to write
+  uint8_t count;
+  uint64_t lastArrival;
+  float arrivalInterval;
+
+  uint16_t playoutDelay = 0;
+  uint16_t holdTime = FFB_FORCE_STREAM_HOLD_TIME;
+  uint16_t decayTime = FFB_FORCE_STREAM_DECAY_TIME;
+};
+
+#endif
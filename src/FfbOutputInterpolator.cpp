@@ -0,0 +1,156 @@
+/*
+  Force Feedback Joystick
+  Upsampling of engine outputs to motor controller setpoints.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+
+#include "FfbOutputInterpolator.h"
+
+FfbOutputInterpolator::FfbOutputInterpolator(uint8_t outputRatio, Mode interpolationMode) : ratio{outputRatio},
+                                                                                           mode{interpolationMode}
+{
+  if (ratio == 0)
+    ratio = 1;
+  Reset();
+}
+
+void FfbOutputInterpolator::Reset()
+{
+  outputCount = 0;
+  head = 0;
+  tail = 0;
+  skipTo = 0;
+  skipRequest = 0;
+  skipAck = 0;
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    lastSetpoint[i] = 0;
+  }
+}
+
+uint8_t FfbOutputInterpolator::Push(const int32_t force[NUM_AXES])
+{
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    outputs[0][i] = outputs[1][i];
+    outputs[1][i] = outputs[2][i];
+    outputs[2][i] = force[i];
+  }
+
+  // the first output has nothing to interpolate from
+  if (outputCount < 3)
+    ++outputCount;
+  if (outputCount == 1)
+  {
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      outputs[0][i] = outputs[1][i] = outputs[2][i];
+    }
+  }
+
+  // setpoints of an older tick that are still waiting are stale once this one arrives
+  uint8_t available = GetAvailable();
+  if (available >= ratio || FFB_OUTPUT_RING_SIZE - 1 - available < ratio)
+  {
+    skipTo = head;
+    ++skipRequest;
+  }
+
+  // the consumer may still read from its own tail until it acknowledged the skip, so that is where writing stops
+  uint8_t written = 0;
+  for (uint8_t step = 1; step <= ratio; ++step)
+  {
+    uint8_t next = (head + 1) & (FFB_OUTPUT_RING_SIZE - 1);
+    if (next == tail)
+      break;
+
+    float t = (float)step / ratio;
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      ring[head][i] = Interpolate(i, t);
+    }
+    head = next;
+    ++written;
+  }
+  return written;
+}
+
+bool FfbOutputInterpolator::Pop(int32_t setpoint[NUM_AXES])
+{
+  uint8_t request = skipRequest;
+  if (request != skipAck)
+  {
+    tail = skipTo;
+    skipAck = request;
+  }
+
+  bool available = tail != head;
+  if (available)
+  {
+    for (uint8_t i = 0; i < NUM_AXES; ++i)
+    {
+      lastSetpoint[i] = ring[tail][i];
+    }
+    tail = (tail + 1) & (FFB_OUTPUT_RING_SIZE - 1);
+  }
+
+  for (uint8_t i = 0; i < NUM_AXES; ++i)
+  {
+    setpoint[i] = lastSetpoint[i];
+  }
+  return available;
+}
+
+uint8_t FfbOutputInterpolator::GetAvailable() const
+{
+  return (head - GetTail()) & (FFB_OUTPUT_RING_SIZE - 1);
+}
+
+uint8_t FfbOutputInterpolator::GetTail() const
+{
+  return skipRequest != skipAck ? skipTo : tail;
+}
+
+float FfbOutputInterpolator::Interpolate(uint8_t axis, float t) const
+{
+  float p0 = outputs[1][axis];
+  float p1 = outputs[2][axis];
+
+  switch (mode)
+  {
+  case hermite:
+  {
+    float m0 = (p1 - outputs[0][axis]) / 2;
+    float m1 = p1 - p0;
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return (2 * t3 - 3 * t2 + 1) * p0 + (t3 - 2 * t2 + t) * m0 + (-2 * t3 + 3 * t2) * p1 + (t3 - t2) * m1;
+  }
+  case minimumJerk:
+  {
+    float t3 = t * t * t;
+    float s = t3 * (10 - 15 * t + 6 * t * t);
+    return p0 + (p1 - p0) * s;
+  }
+  case linear:
+  default:
+    return p0 + (p1 - p0) * t;
+  }
+}
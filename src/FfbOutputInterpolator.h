@@ -0,0 +1,91 @@
+/*
+  Force Feedback Joystick
+  Upsampling of engine outputs to motor controller setpoints.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBOUTPUTINTERPOLATOR_h
+#define FFBOUTPUTINTERPOLATOR_h
+
+#include "HIDReportType.h"
+
+// Setpoints the ring buffer holds, a power of two up to 128
+#ifndef FFB_OUTPUT_RING_SIZE
+#define FFB_OUTPUT_RING_SIZE 64
+#endif
+static_assert(FFB_OUTPUT_RING_SIZE >= 2 && FFB_OUTPUT_RING_SIZE <= 128 && (FFB_OUTPUT_RING_SIZE & (FFB_OUTPUT_RING_SIZE - 1)) == 0,
+              "FFB_OUTPUT_RING_SIZE must be a power of two between 2 and 128");
+
+// Turns engine outputs into ratio setpoints per engine tick for a faster motor loop.
+// Push runs after every engine tick and interpolates from the previous output to the new one, so the added latency
+// is one engine tick. Pop runs in the motor loop or ISR. There is one producer and one consumer, each index is
+// a single byte written by one side only, so no locking is needed.
+// The indices are volatile, not atomic: the two sides must run on the same core, one of them in an ISR. Threads on
+// different cores need their own synchronization around Push and Pop.
+// When the consumer is a whole engine tick or more behind, Push drops the setpoints it did not pop yet, so the
+// output never lags by more than one tick. The producer cannot move the tail, it asks the consumer to skip instead.
+// Until the consumer acknowledged the skip, Push does not write over the skipped setpoints, so with a ratio above
+// half the ring that tick gets fewer setpoints.
+class FfbOutputInterpolator
+{
+public:
+  enum Mode
+  {
+    linear,
+    // Catmull-Rom tangents from the last three outputs, the end tangent is one sided to avoid waiting for the next output
+    hermite,
+    // zero velocity and acceleration at every engine output
+    minimumJerk
+  };
+
+  FfbOutputInterpolator(uint8_t ratio, Mode mode = linear);
+
+  void Reset();
+  // Returns the number of setpoints written, less than ratio only when ratio does not fit in the ring
+  uint8_t Push(const int32_t force[NUM_AXES]);
+  // Returns false and repeats the last setpoint when the ring is empty
+  bool Pop(int32_t setpoint[NUM_AXES]);
+  uint8_t GetAvailable() const;
+
+private:
+  float Interpolate(uint8_t axis, float t) const;
+
+  uint8_t ratio;
+  Mode mode;
+
+  // producer side
+  float outputs[3][NUM_AXES]; // oldest first, outputs[2] is the newest
+  uint8_t outputCount;
+
+  // consumer side
+  int32_t lastSetpoint[NUM_AXES];
+
+  volatile int32_t ring[FFB_OUTPUT_RING_SIZE][NUM_AXES];
+  volatile uint8_t head; // written by Push
+  volatile uint8_t tail; // written by Pop
+  // Push sets skipTo and increments skipRequest to drop everything before skipTo, Pop acknowledges in skipAck
+  volatile uint8_t skipTo;
+  volatile uint8_t skipRequest; // written by Push
+  volatile uint8_t skipAck;     // written by Pop
+
+  // tail as the producer sees it, a requested skip counts as done
+  uint8_t GetTail() const;
+};
+
+#endif
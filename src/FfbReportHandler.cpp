@@ -25,13 +25,22 @@
 */
 
 #include "FfbReportHandler.h"
+#include "FfbDirection.h"
 #include <string.h>
-#include <math.h>
+
+static uint8_t TriggerButtonMask(uint8_t triggerButton)
+{
+  if (triggerButton == 0 || triggerButton > 8)
+    return 0;
+  return 1 << (triggerButton - 1);
+}
 
 FfbReportHandler::FfbReportHandler(uint64_t (*pTime)(void)) : getTimeMilli{pTime}
 {
   devicePaused = 0;
   pauseTime = 0;
+  pausedDuration = 0;
+  triggerButtons = 0;
   FreeAllEffects();
 }
 
@@ -49,11 +58,205 @@ TEffectState *FfbReportHandler::GetEffect(uint8_t id)
   return nullptr;
 }
 
-const TEffectState *FfbReportHandler::GetEffectStates()
+const TEffectState *FfbReportHandler::GetEffectStates() const
 {
   return (const TEffectState *)gEffectStates;
 }
 
+uint64_t FfbReportHandler::GetEffectTime(uint64_t deviceTime) const
+{
+  if (devicePaused)
+    deviceTime = pauseTime;
+
+  return deviceTime - pausedDuration;
+}
+
+void FfbReportHandler::UpdateTriggers(uint8_t buttons, uint8_t pressed, uint8_t released, uint64_t time)
+{
+  triggerButtons = buttons;
+  ++revision;
+  for (uint8_t id = 0; id < MAX_EFFECTS; ++id)
+  {
+    TEffectState &effect = gEffectStates[id];
+    uint8_t triggerButton = effect.block.triggerButton;
+    if (!(effect.state & MEFFECTSTATE_PLAYING) || triggerButton == USB_NO_TRIGGER_BUTTON)
+      continue;
+
+    uint8_t buttonMask = TriggerButtonMask(triggerButton);
+    if (!((pressed | released) & buttonMask))
+      continue;
+
+    if ((buttons & pressed) & buttonMask)
+    {
+      ArmTriggerEffect(&effect, time);
+    }
+    else if (!(buttons & buttonMask))
+    {
+      effect.triggerButtonLatch = false;
+      scheduler.Remove(id);
+    }
+  }
+}
+
+bool FfbReportHandler::AdvanceEffects(uint64_t time)
+{
+  if (!scheduler.Advance(time))
+    return false;
+
+  ++revision;
+  return true;
+}
+
+uint32_t FfbReportHandler::GetRevision() const
+{
+  return revision;
+}
+
+const uint8_t *FfbReportHandler::GetActiveEffects(uint8_t &count) const
+{
+  return scheduler.GetActiveEffects(count);
+}
+
+const TCustomForce *FfbReportHandler::GetCustomForce(uint8_t effectIdx) const
+{
+  for (uint8_t slot = 0; slot < FFB_MAX_CUSTOM_EFFECTS; ++slot)
+  {
+    if (customForces[slot].effectIdx == effectIdx)
+      return &customForces[slot];
+  }
+  return nullptr;
+}
+
+TCustomForce *FfbReportHandler::AllocateCustomForce(uint8_t effectIdx)
+{
+  TCustomForce *customForce = (TCustomForce *)GetCustomForce(effectIdx);
+  if (customForce != nullptr)
+    return customForce;
+
+  for (uint8_t slot = 0; slot < FFB_MAX_CUSTOM_EFFECTS; ++slot)
+  {
+    if (customForces[slot].effectIdx == CUSTOM_FORCE_FREE)
+    {
+      customForce = &customForces[slot];
+      memset((void *)customForce, 0, sizeof(TCustomForce));
+      customForce->effectIdx = effectIdx;
+      return customForce;
+    }
+  }
+  return nullptr;
+}
+
+void FfbReportHandler::FreeCustomForce(uint8_t effectIdx)
+{
+  TCustomForce *customForce = (TCustomForce *)GetCustomForce(effectIdx);
+  if (customForce != nullptr)
+    customForce->effectIdx = CUSTOM_FORCE_FREE;
+}
+
+const TWavetable *FfbReportHandler::GetWavetable(uint8_t effectIdx) const
+{
+  for (uint8_t slot = 0; slot < FFB_MAX_WAVETABLES; ++slot)
+  {
+    if (wavetables[slot].effectIdx == effectIdx)
+      return &wavetables[slot];
+  }
+  return nullptr;
+}
+
+TWavetable *FfbReportHandler::AllocateWavetable(uint8_t effectIdx)
+{
+  TWavetable *wavetable = (TWavetable *)GetWavetable(effectIdx);
+  if (wavetable != nullptr)
+    return wavetable;
+
+  for (uint8_t slot = 0; slot < FFB_MAX_WAVETABLES; ++slot)
+  {
+    if (wavetables[slot].effectIdx == WAVETABLE_FREE)
+    {
+      wavetable = &wavetables[slot];
+      memset((void *)wavetable, 0, sizeof(TWavetable));
+      wavetable->effectIdx = effectIdx;
+      return wavetable;
+    }
+  }
+  return nullptr;
+}
+
+void FfbReportHandler::FreeWavetable(uint8_t effectIdx)
+{
+  TWavetable *wavetable = (TWavetable *)GetWavetable(effectIdx);
+  if (wavetable != nullptr)
+    wavetable->effectIdx = WAVETABLE_FREE;
+}
+
+const TResponseCurve *FfbReportHandler::GetResponseCurve(uint8_t effectIdx, uint8_t parameterBlockOffset) const
+{
+  for (uint8_t slot = 0; slot < FFB_MAX_RESPONSE_CURVES; ++slot)
+  {
+    if (responseCurves[slot].effectIdx == effectIdx && responseCurves[slot].parameterBlockOffset == parameterBlockOffset)
+      return &responseCurves[slot];
+  }
+  return nullptr;
+}
+
+bool FfbReportHandler::HasResponseCurve(uint8_t effectIdx) const
+{
+  for (uint8_t slot = 0; slot < FFB_MAX_RESPONSE_CURVES; ++slot)
+  {
+    if (responseCurves[slot].effectIdx == effectIdx)
+      return true;
+  }
+  return false;
+}
+
+void FfbReportHandler::FreeResponseCurves(uint8_t effectIdx)
+{
+  for (uint8_t slot = 0; slot < FFB_MAX_RESPONSE_CURVES; ++slot)
+  {
+    if (responseCurves[slot].effectIdx == effectIdx)
+      responseCurves[slot].effectIdx = RESPONSE_CURVE_FREE;
+  }
+}
+
+const TModulation *FfbReportHandler::GetModulations(uint8_t &activeCount) const
+{
+  activeCount = modulationCount;
+  return modulations;
+}
+
+uint64_t FfbReportHandler::GetNextDeadline() const
+{
+  uint64_t deadline = scheduler.GetNextDeadline();
+  uint64_t stepDeadline = sequencer.GetNextDeadline();
+  if (stepDeadline < deadline)
+    deadline = stepDeadline;
+  if (devicePaused || deadline == FFB_TIME_NEVER)
+    deadline = FFB_TIME_NEVER;
+  else
+    deadline += pausedDuration;
+
+  if (timedOperationCount > 0 && timedOperations[0].time < deadline)
+    deadline = timedOperations[0].time;
+  return deadline;
+}
+
+void FfbReportHandler::ApplyTimedOperations(uint64_t deviceTime)
+{
+  uint8_t applied = 0;
+  while (applied < timedOperationCount && timedOperations[applied].time <= deviceTime)
+  {
+    // effects start at the apply time, not at the tick that got to them
+    FfbHandle_EffectOperation(&timedOperations[applied].operation, timedOperations[applied].time);
+    ++applied;
+  }
+  if (applied == 0)
+    return;
+
+  ++revision;
+  timedOperationCount -= applied;
+  memmove(timedOperations, timedOperations + applied, timedOperationCount * sizeof(TTimedOperation));
+}
+
 uint8_t FfbReportHandler::GetNextFreeEffect(void)
 {
   for (int id = 0; id < MAX_EFFECTS; ++id)
@@ -73,18 +276,59 @@ void FfbReportHandler::StopAllEffects(void)
     StopEffect(&gEffectStates[id]);
 }
 
-void FfbReportHandler::StartEffect(TEffectState *effectState)
+void FfbReportHandler::StartEffect(TEffectState *effectState, uint64_t time)
 {
   effectState->state = MEFFECTSTATE_PLAYING;
-  if (effectState->block.triggerButton != 0xFF)
-    effectState->startTime = 0;
-  else
-    effectState->startTime = getTimeMilli() + effectState->block.startDelay;
+  uint8_t triggerButton = effectState->block.triggerButton;
+  if (triggerButton != USB_NO_TRIGGER_BUTTON)
+  {
+    // waits for the button press unless the button is already held
+    effectState->triggerButtonLatch = false;
+    scheduler.Remove(effectState - gEffectStates);
+    if (triggerButtons & TriggerButtonMask(triggerButton))
+      ArmTriggerEffect(effectState, GetEffectTime(time));
+    return;
+  }
+
+  effectState->startTime = GetEffectTime(time) + effectState->block.startDelay;
+  ScheduleEffect(effectState);
+}
+
+void FfbReportHandler::ArmTriggerEffect(TEffectState *effectState, uint64_t time)
+{
+  effectState->startTime = time;
+  effectState->triggerButtonLatch = true;
+  ScheduleEffect(effectState);
+}
+
+void FfbReportHandler::ScheduleEffect(TEffectState *effectState)
+{
+  uint8_t effectIdx = effectState - gEffectStates;
+  if (effectState->block.triggerButton != USB_NO_TRIGGER_BUTTON && !effectState->triggerButtonLatch)
+  {
+    scheduler.Remove(effectIdx);
+    return;
+  }
+
+  uint16_t duration = effectState->block.duration;
+  if (duration == USB_DURATION_INFINITE)
+  {
+    scheduler.Schedule(effectIdx, effectState->startTime, FFB_TIME_NEVER);
+    return;
+  }
+
+  // trigger effects repeat while the button is held
+  uint32_t period = 0;
+  if (effectState->block.triggerButton != USB_NO_TRIGGER_BUTTON)
+    period = duration + effectState->block.triggerRepeatInterval;
+  scheduler.Schedule(effectIdx, effectState->startTime, effectState->startTime + duration, period);
 }
 
 void FfbReportHandler::StopEffect(TEffectState *effectState)
 {
   effectState->state &= ~MEFFECTSTATE_PLAYING;
+  effectState->triggerButtonLatch = false;
+  scheduler.Remove(effectState - gEffectStates);
 }
 
 void FfbReportHandler::FreeEffect(uint8_t id)
@@ -96,16 +340,59 @@ void FfbReportHandler::FreeEffect(uint8_t id)
   }
 
   effectState->state = MEFFECTSTATE_FREE;
+  scheduler.Remove(id - 1);
+  bulkUpdates[id - 1].parameters = 0;
+  for (uint8_t slot = 0; slot < FFB_MAX_MODULATIONS; ++slot)
+  {
+    TModulation &modulation = modulations[slot];
+    if (modulation.destination != MODULATION_OFF && (modulation.sourceIdx == id - 1 || modulation.targetIdx == id - 1))
+    {
+      modulation.destination = MODULATION_OFF;
+      --modulationCount;
+    }
+  }
+  uint8_t kept = 0;
+  for (uint8_t idx = 0; idx < timedOperationCount; ++idx)
+  {
+    if (timedOperations[idx].operation.effectBlockIndex != id)
+      timedOperations[kept++] = timedOperations[idx];
+  }
+  timedOperationCount = kept;
+  FreeCustomForce(id - 1);
+  FreeWavetable(id - 1);
+  FreeResponseCurves(id - 1);
   pidBlockLoad.ramPoolAvailable += SIZE_EFFECT;
 }
 
 void FfbReportHandler::FreeAllEffects(void)
 {
   memset((void *)&gEffectStates, 0, sizeof(gEffectStates));
+  for (uint8_t slot = 0; slot < FFB_MAX_CUSTOM_EFFECTS; ++slot)
+  {
+    customForces[slot].effectIdx = CUSTOM_FORCE_FREE;
+  }
+  for (uint8_t slot = 0; slot < FFB_MAX_WAVETABLES; ++slot)
+  {
+    wavetables[slot].effectIdx = WAVETABLE_FREE;
+  }
+  for (uint8_t slot = 0; slot < FFB_MAX_RESPONSE_CURVES; ++slot)
+  {
+    responseCurves[slot].effectIdx = RESPONSE_CURVE_FREE;
+  }
+  scheduler.Reset();
+  sequencer.Reset();
+  timedOperationCount = 0;
+  memset(bulkUpdates, 0, sizeof(bulkUpdates));
+  memset(modulations, 0, sizeof(modulations));
+  modulationCount = 0;
+  bulkUpdatePending = false;
+  // coalesced reports were sent for the effects freed here
+  pendingCount = 0;
+  forceStream.Reset();
   pidBlockLoad.ramPoolAvailable = MEMORY_SIZE;
 }
 
-void FfbReportHandler::FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_Output_Data_t *data)
+void FfbReportHandler::FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_Output_Data_t *data, uint64_t time)
 {
   uint8_t effectBlockIndex = data->effectBlockIndex;
   uint8_t operation = data->operation;
@@ -123,7 +410,7 @@ void FfbReportHandler::FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_O
       effectState->block.duration *= data->loopCount;
     if (data->loopCount == 0xFF)
       effectState->block.duration = USB_DURATION_INFINITE;
-    StartEffect(effectState);
+    StartEffect(effectState, time);
     break;
 
   case 2:
@@ -132,7 +419,7 @@ void FfbReportHandler::FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_O
     StopAllEffects();
 
     // Then start the given effect
-    StartEffect(effectState);
+    StartEffect(effectState, time);
     break;
   case 3:
     // Stop
@@ -140,6 +427,89 @@ void FfbReportHandler::FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_O
   }
 }
 
+void FfbReportHandler::FfbHandle_TimedEffectOperation(USB_FFBReport_TimedEffectOperation_Output_Data_t *data, uint64_t time)
+{
+  USB_FFBReport_EffectOperation_Output_Data_t operation = {SET_EFFECT_OPERATION_REPORT, data->effectBlockIndex, data->operation, data->loopCount};
+
+  // the apply time is the device time with the same low 32 bits nearest to now
+  int32_t delta = (int32_t)(data->applyTime - (uint32_t)time);
+  if (delta <= 0 || timedOperationCount == FFB_MAX_TIMED_OPERATIONS)
+  {
+    // late operations and those that do not fit the queue are applied right away
+    FfbHandle_EffectOperation(&operation, time);
+    return;
+  }
+
+  uint64_t applyTime = time + delta;
+  uint8_t idx = timedOperationCount++;
+  for (; idx > 0 && timedOperations[idx - 1].time > applyTime; --idx)
+  {
+    timedOperations[idx] = timedOperations[idx - 1];
+  }
+  timedOperations[idx].time = applyTime;
+  timedOperations[idx].operation = operation;
+}
+
+void FfbReportHandler::FfbHandle_BulkUpdate(USB_FFBReport_BulkUpdate_Output_Data_t *data)
+{
+  uint8_t entryCount = data->entryCount < FFB_BULK_UPDATE_ENTRIES ? data->entryCount : FFB_BULK_UPDATE_ENTRIES;
+  for (uint8_t idx = 0; idx < entryCount; ++idx)
+  {
+    const USB_FFBReport_BulkUpdateEntry_t &entry = data->entries[idx];
+    TEffectState *effectState = GetEffect(entry.effectBlockIndex);
+    if (effectState == nullptr)
+      continue;
+
+    // a later entry for the same parameter replaces the staged one
+    TBulkUpdate &update = bulkUpdates[entry.effectBlockIndex - 1];
+    if (entry.parameter == BULK_UPDATE_MAGNITUDE)
+      update.magnitude = entry.value;
+    else if (entry.parameter == BULK_UPDATE_OFFSET)
+      update.offset = entry.value;
+    else
+      continue;
+    update.parameters |= entry.parameter;
+    bulkUpdatePending = true;
+  }
+}
+
+void FfbReportHandler::FfbHandle_SetTimeline(USB_FFBReport_SetTimeline_Output_Data_t *data)
+{
+  uint8_t count = 0;
+  if (data->stepCount > data->stepOffset)
+    count = data->stepCount - data->stepOffset;
+  if (count > FFB_TIMELINE_STEPS_PER_REPORT)
+    count = FFB_TIMELINE_STEPS_PER_REPORT;
+  sequencer.SetSteps(data->timelineIndex - 1, data->stepOffset, data->stepCount, data->loopPeriod, data->steps, count);
+}
+
+void FfbReportHandler::FfbHandle_TimelineOperation(USB_FFBReport_TimelineOperation_Output_Data_t *data, uint64_t time)
+{
+  if (data->operation == 1)
+    sequencer.Start(data->timelineIndex - 1, GetEffectTime(time));
+  else if (data->operation == 2)
+    sequencer.Stop(data->timelineIndex - 1);
+}
+
+void FfbReportHandler::FfbHandle_SetModulation(USB_FFBReport_SetModulation_Output_Data_t *data)
+{
+  uint8_t slot = data->modulationIndex - 1;
+  if (slot >= FFB_MAX_MODULATIONS)
+    return;
+
+  TModulation &modulation = modulations[slot];
+  bool wasActive = modulation.destination != MODULATION_OFF;
+  bool valid = GetEffect(data->sourceBlockIndex) != nullptr && GetEffect(data->targetBlockIndex) != nullptr &&
+               data->sourceBlockIndex != data->targetBlockIndex && data->destination <= MODULATION_PERIOD;
+  modulation.sourceIdx = data->sourceBlockIndex - 1;
+  modulation.targetIdx = data->targetBlockIndex - 1;
+  modulation.depth = data->depth;
+  modulation.destination = valid ? data->destination : MODULATION_OFF;
+
+  bool isActive = modulation.destination != MODULATION_OFF;
+  modulationCount += isActive - wasActive;
+}
+
 void FfbReportHandler::FfbHandle_BlockFree(USB_FFBReport_BlockFree_Output_Data_t *data)
 {
   uint8_t eid = data->effectBlockIndex;
@@ -154,7 +524,7 @@ void FfbReportHandler::FfbHandle_BlockFree(USB_FFBReport_BlockFree_Output_Data_t
   }
 }
 
-void FfbReportHandler::FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Output_Data_t *data)
+void FfbReportHandler::FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Output_Data_t *data, uint64_t time)
 {
 
   uint8_t control = data->control;
@@ -172,6 +542,9 @@ void FfbReportHandler::FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Outpu
   case 3:
     // 3=Stop All Effects
     StopAllEffects();
+    forceStream.Reset();
+    for (uint8_t idx = 0; idx < FFB_MAX_TIMELINES; ++idx)
+      sequencer.Stop(idx);
     break;
   case 4:
     //  4=Reset
@@ -179,25 +552,19 @@ void FfbReportHandler::FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Outpu
     break;
   case 5:
     // 5=Pause
+    if (devicePaused)
+      break;
+    pauseTime = time;
     devicePaused = 1;
     pidState.status |= 1;
-    pauseTime = getTimeMilli();
     break;
   case 6:
     // 6=Continue
+    if (!devicePaused)
+      break;
+    pausedDuration += time - pauseTime;
     devicePaused = 0;
     pidState.status &= ~(0x01);
-
-    uint32_t pauseLength = getTimeMilli() - pauseTime;
-    for (int id = 0; id < MAX_EFFECTS; ++id)
-    {
-      if (gEffectStates[id].state & MEFFECTSTATE_PLAYING)
-      {
-        if (pauseTime < gEffectStates[id].startTime)
-          continue;
-        gEffectStates[id].startTime += pauseLength;
-      }
-    }
     break;
   }
 }
@@ -208,14 +575,98 @@ void FfbReportHandler::FfbHandle_DeviceGain(USB_FFBReport_DeviceGain_Output_Data
 
 void FfbReportHandler::FfbHandle_SetCustomForce(USB_FFBReport_SetCustomForce_Output_Data_t *data)
 {
+  if (GetEffect(data->effectBlockIndex) == nullptr)
+    return;
+
+  TCustomForce *customForce = AllocateCustomForce(data->effectBlockIndex - 1);
+  if (customForce == nullptr)
+    return;
+
+  customForce->sampleCount = data->sampleCount < FFB_CUSTOM_FORCE_MAX_SAMPLES ? data->sampleCount : FFB_CUSTOM_FORCE_MAX_SAMPLES;
+  customForce->samplePeriod = data->samplePeriod;
 }
 
 void FfbReportHandler::FfbHandle_SetCustomForceData(USB_FFBReport_SetCustomForceData_Output_Data_t *data)
 {
+  if (GetEffect(data->effectBlockIndex) == nullptr)
+    return;
+
+  TCustomForce *customForce = AllocateCustomForce(data->effectBlockIndex - 1);
+  if (customForce == nullptr)
+    return;
+
+  uint8_t dataCount = sizeof(data->data);
+  for (uint8_t i = 0; i < dataCount; ++i)
+  {
+    customForce->samples[(data->dataOffset + i) % FFB_CUSTOM_FORCE_MAX_SAMPLES] = data->data[i];
+  }
+
+  uint32_t written = (uint32_t)data->dataOffset + dataCount;
+  if (written > FFB_CUSTOM_FORCE_MAX_SAMPLES)
+    written = FFB_CUSTOM_FORCE_MAX_SAMPLES;
+  if (written > customForce->writtenCount)
+    customForce->writtenCount = written;
+}
+
+void FfbReportHandler::FfbHandle_SetWavetableData(USB_FFBReport_SetWavetableData_Output_Data_t *data)
+{
+  if (GetEffect(data->effectBlockIndex) == nullptr || data->dataOffset >= FFB_WAVETABLE_MAX_POINTS)
+    return;
+
+  TWavetable *wavetable = AllocateWavetable(data->effectBlockIndex - 1);
+  if (wavetable == nullptr)
+    return;
+
+  wavetable->pointCount = data->pointCount < FFB_WAVETABLE_MAX_POINTS ? data->pointCount : FFB_WAVETABLE_MAX_POINTS;
+  uint16_t count = FFB_WAVETABLE_MAX_POINTS - data->dataOffset;
+  if (count > FFB_WAVETABLE_POINTS_PER_REPORT)
+    count = FFB_WAVETABLE_POINTS_PER_REPORT;
+  memcpy(&wavetable->points[data->dataOffset], data->points, count * sizeof(int16_t));
+}
+
+void FfbReportHandler::FfbHandle_SetResponseCurve(USB_FFBReport_SetResponseCurve_Output_Data_t *data)
+{
+  uint8_t parameterBlockOffset = data->parameterBlockOffset & 0x0F;
+  if (parameterBlockOffset > NUM_AXES - 1 || GetEffect(data->effectBlockIndex) == nullptr)
+    return;
+
+  uint8_t effectIdx = data->effectBlockIndex - 1;
+  TResponseCurve *curve = (TResponseCurve *)GetResponseCurve(effectIdx, parameterBlockOffset);
+  if (data->pointCount < 2)
+  {
+    // less than a segment makes the block linear again
+    if (curve != nullptr)
+      curve->effectIdx = RESPONSE_CURVE_FREE;
+    return;
+  }
+
+  for (uint8_t slot = 0; slot < FFB_MAX_RESPONSE_CURVES && curve == nullptr; ++slot)
+  {
+    if (responseCurves[slot].effectIdx == RESPONSE_CURVE_FREE)
+      curve = &responseCurves[slot];
+  }
+  if (curve == nullptr)
+    return;
+
+  curve->effectIdx = effectIdx;
+  curve->parameterBlockOffset = parameterBlockOffset;
+  curve->pointCount = data->pointCount < FFB_RESPONSE_CURVE_MAX_POINTS ? data->pointCount : FFB_RESPONSE_CURVE_MAX_POINTS;
+  memcpy(curve->points, data->points, sizeof(curve->points));
+}
+
+void FfbReportHandler::FfbHandle_SetDownloadForceSample(USB_FFBReport_SetDownloadForceSample_Output_Data_t *data, uint64_t time)
+{
+  forceStream.Push(time, data->x, data->y);
 }
 
-void FfbReportHandler::FfbHandle_SetDownloadForceSample(USB_FFBReport_SetDownloadForceSample_Output_Data_t *data)
+void FfbReportHandler::SetStreamPlayout(uint16_t delay, uint16_t holdTime, uint16_t decayTime)
 {
+  forceStream.SetPlayout(delay, holdTime, decayTime);
+}
+
+void FfbReportHandler::AddStreamForce(uint64_t deviceTime, float force[NUM_AXES]) const
+{
+  forceStream.AddForce(deviceTime, force);
 }
 
 void FfbReportHandler::FfbHandle_SetEffect(USB_FFBReport_SetEffect_Output_Data_t *data)
@@ -229,23 +680,29 @@ void FfbReportHandler::FfbHandle_SetEffect(USB_FFBReport_SetEffect_Output_Data_t
   USB_FFBReport_SetEffect_Output_Data_t *block = &effectState->block;
   memcpy((void *)block, data, sizeof(USB_FFBReport_SetEffect_Output_Data_t));
 
-  float normalizedDirectionX = data->directionX;
-  normalizedDirectionX /= USB_NORMALIZE_RAD;
-
-  float normalizedDirectionY = data->directionY;
-  normalizedDirectionY /= USB_NORMALIZE_RAD;
+  uint16_t directions[] = {data->directionX, data->directionY};
 
   uint8_t enableAxis = data->enableAxis;
   if (enableAxis & DIRECTION_ENABLE)
   {
-    effectState->directionUnitVec[0] = cos(normalizedDirectionX);
-    effectState->directionUnitVec[1] = sin(normalizedDirectionX);
+    FfbDirectionToUnitVec(directions, sizeof(directions) / sizeof(directions[0]), effectState->directionUnitVec, NUM_AXES);
   }
   else
   {
-    effectState->directionUnitVec[0] = cos(normalizedDirectionX);
-    effectState->directionUnitVec[1] = sin(normalizedDirectionY);
+    float sinValue, cosValue;
+    FfbSinCos(data->directionX, sinValue, cosValue);
+    effectState->directionUnitVec[0] = cosValue;
+    FfbSinCos(data->directionY, sinValue, cosValue);
+    effectState->directionUnitVec[1] = sinValue;
+    for (uint8_t i = 2; i < NUM_AXES; ++i)
+    {
+      effectState->directionUnitVec[i] = 1;
+    }
   }
+
+  // duration of a playing effect may change
+  if (effectState->state & MEFFECTSTATE_PLAYING)
+    ScheduleEffect(effectState);
 }
 
 void FfbReportHandler::SetEnvelope(USB_FFBReport_SetEnvelope_Output_Data_t *data)
@@ -315,6 +772,9 @@ void FfbReportHandler::SetRampForce(USB_FFBReport_SetRampForce_Output_Data_t *da
 
 void FfbReportHandler::FfbOnCreateNewEffect(USB_FFBReport_CreateNewEffect_Feature_Data_t *inData)
 {
+  // reports sent before may free the slot picked here
+  FlushPendingReports();
+  ++revision;
   pidBlockLoad.reportId = 6;
   pidBlockLoad.effectBlockIndex = GetNextFreeEffect();
 
@@ -337,6 +797,7 @@ void FfbReportHandler::FfbOnCreateNewEffect(USB_FFBReport_CreateNewEffect_Featur
 
 uint8_t *FfbReportHandler::FfbOnPIDPool()
 {
+  ++revision;
   FreeAllEffects();
 
   pidPoolReport.reportId = 7;
@@ -356,54 +817,242 @@ uint8_t *FfbReportHandler::FfbOnPIDStatus()
   return (uint8_t *)&pidState;
 }
 
+uint64_t FfbReportHandler::GetTime()
+{
+  return getTimeMilli != nullptr ? getTimeMilli() : lastTime;
+}
+
 void FfbReportHandler::FfbOnUsbData(uint8_t *data, uint16_t len)
 {
+  FfbOnUsbData(data, len, GetTime());
+}
+
+void FfbReportHandler::FfbOnUsbData(uint8_t *data, uint16_t len, uint64_t time)
+{
+  lastTime = time;
+  if (len == 0)
+    return;
+  const TOutputReport *report = GetOutputReport(data[0]);
+  if (report == nullptr || len < report->size)
+    return;
+  DispatchReport(report, data, time);
+}
 
-  uint8_t effectId = data[1]; // effectBlockIndex is always the second byte.
-  switch (data[0])            // reportID
+uint16_t FfbReportHandler::FfbOnUsbBatch(const uint8_t *data, uint16_t len)
+{
+  return FfbOnUsbBatch(data, len, GetTime());
+}
+
+uint16_t FfbReportHandler::FfbOnUsbBatch(const uint8_t *data, uint16_t len, uint64_t time)
+{
+  lastTime = time;
+  uint16_t count = 0;
+  uint16_t offset = 0;
+  while (offset < len)
   {
-  case SET_EFFECT_REPORT:
-    FfbHandle_SetEffect((USB_FFBReport_SetEffect_Output_Data_t *)data);
-    break;
-  case SET_ENVELOPE_REPORT:
-    SetEnvelope((USB_FFBReport_SetEnvelope_Output_Data_t *)data);
-    break;
-  case SET_CONDITION_REPORT:
-    SetCondition((USB_FFBReport_SetCondition_Output_Data_t *)data);
-    break;
-  case SET_PERIODIC_REPORT:
-    SetPeriodic((USB_FFBReport_SetPeriodic_Output_Data_t *)data);
-    break;
-  case SET_CONSTANT_FORCE_REPORT:
-    SetConstantForce((USB_FFBReport_SetConstantForce_Output_Data_t *)data);
-    break;
-  case SET_RAMP_FORCE_REPORT:
-    SetRampForce((USB_FFBReport_SetRampForce_Output_Data_t *)data);
-    break;
-  case 7:
-    FfbHandle_SetCustomForceData((USB_FFBReport_SetCustomForceData_Output_Data_t *)data);
-    break;
-  case 8:
-    FfbHandle_SetDownloadForceSample((USB_FFBReport_SetDownloadForceSample_Output_Data_t *)data);
-    break;
-  case 9:
-    break;
-  case SET_EFFECT_OPERATION_REPORT:
-    FfbHandle_EffectOperation((USB_FFBReport_EffectOperation_Output_Data_t *)data);
-    break;
-  case SET_BLOCK_FREE_REPORT:
-    FfbHandle_BlockFree((USB_FFBReport_BlockFree_Output_Data_t *)data);
-    break;
-  case SET_DEVICE_CONTROL_REPORT:
-    FfbHandle_DeviceControl((USB_FFBReport_DeviceControl_Output_Data_t *)data);
-    break;
-  case SET_DEVICE_GAIN_REPORT:
-    FfbHandle_DeviceGain((USB_FFBReport_DeviceGain_Output_Data_t *)data);
-    break;
-  case 14:
-    FfbHandle_SetCustomForce((USB_FFBReport_SetCustomForce_Output_Data_t *)data);
+    // there is no way to find the next report after an unknown or truncated one
+    const TOutputReport *report = GetOutputReport(data[offset]);
+    if (report == nullptr || len - offset < report->size)
+      break;
+    DispatchReport(report, data + offset, time);
+    offset += report->size;
+    ++count;
+  }
+  return count;
+}
+
+void FfbReportHandler::SetCoalescing(bool enable)
+{
+  if (!enable)
+    FlushPendingReports();
+  coalescing = enable;
+}
+
+void FfbReportHandler::FlushPendingReports()
+{
+  if (pendingCount == 0)
+    return;
+
+  for (uint8_t idx = 0; idx < pendingCount; ++idx)
+  {
+    TPendingReport &pending = pendingReports[idx];
+    GetOutputReport(pending.key >> 16)->dispatch(*this, pending.data, 0);
+  }
+  pendingCount = 0;
+  ++revision;
+}
+
+void FfbReportHandler::ApplyBulkUpdates()
+{
+  if (!bulkUpdatePending)
+    return;
+
+  for (uint8_t idx = 0; idx < MAX_EFFECTS; ++idx)
+  {
+    TBulkUpdate &update = bulkUpdates[idx];
+    if (update.parameters == 0)
+      continue;
+
+    if (update.parameters & BULK_UPDATE_MAGNITUDE)
+      SetEffectParameter(gEffectStates[idx], BULK_UPDATE_MAGNITUDE, update.magnitude);
+    if (update.parameters & BULK_UPDATE_OFFSET)
+      SetEffectParameter(gEffectStates[idx], BULK_UPDATE_OFFSET, update.offset);
+    update.parameters = 0;
+  }
+  bulkUpdatePending = false;
+  ++revision;
+}
+
+void FfbReportHandler::SetEffectParameter(TEffectState &effectState, uint8_t parameter, int16_t value)
+{
+  TEffectParameter &parameters = effectState.parameters[TYPE_SPECIFIC_BLOCK_OFFSET_1];
+  switch (effectState.block.effectType)
+  {
+  case USB_EFFECT_CONSTANT:
+    if (parameter == BULK_UPDATE_MAGNITUDE)
+      parameters.constant.magnitude = value;
     break;
-  default:
+  case USB_EFFECT_SQUARE:
+  case USB_EFFECT_SINE:
+  case USB_EFFECT_TRIANGLE:
+  case USB_EFFECT_SAWTOOTHDOWN:
+  case USB_EFFECT_SAWTOOTHUP:
+  case USB_EFFECT_WAVETABLE:
+    if (parameter == BULK_UPDATE_MAGNITUDE)
+      parameters.periodic.magnitude = value;
+    else if (parameter == BULK_UPDATE_OFFSET)
+      parameters.periodic.offset = value;
     break;
   }
-};
+}
+
+void FfbReportHandler::AdvanceTimelines(uint64_t time)
+{
+  USB_FFBReport_TimelineStep_t step;
+  uint64_t dueTime;
+  bool applied = false;
+  while (sequencer.NextStep(time, step, dueTime))
+  {
+    applied = true;
+    TEffectState *effectState = GetEffect(step.effectBlockIndex);
+    if (effectState == nullptr)
+      continue;
+
+    switch (step.action)
+    {
+    case TIMELINE_START:
+    case TIMELINE_START_SOLO:
+    case TIMELINE_STOP:
+    {
+      // effects start when the step was due, operations take device time
+      USB_FFBReport_EffectOperation_Output_Data_t operation = {SET_EFFECT_OPERATION_REPORT, step.effectBlockIndex, step.action, 0};
+      FfbHandle_EffectOperation(&operation, dueTime + pausedDuration);
+      break;
+    }
+    case TIMELINE_SET_MAGNITUDE:
+      SetEffectParameter(*effectState, BULK_UPDATE_MAGNITUDE, step.value);
+      break;
+    case TIMELINE_SET_OFFSET:
+      SetEffectParameter(*effectState, BULK_UPDATE_OFFSET, step.value);
+      break;
+    }
+  }
+  if (applied)
+    ++revision;
+}
+
+void FfbReportHandler::QueueReport(const TOutputReport *report, const uint8_t *data)
+{
+  // condition reports carry one parameter block per axis
+  uint8_t parameterOffset = data[0] == SET_CONDITION_REPORT ? data[2] & 0x0F : 0;
+  uint32_t key = (uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | parameterOffset;
+
+  uint8_t idx = 0;
+  while (idx < pendingCount && pendingReports[idx].key != key)
+    ++idx;
+  if (idx == FFB_MAX_PENDING_REPORTS)
+  {
+    FlushPendingReports();
+    idx = 0;
+  }
+  if (idx == pendingCount)
+  {
+    pendingReports[idx].key = key;
+    ++pendingCount;
+  }
+  memcpy(&pendingReports[idx].data, data, report->size);
+}
+
+const FfbReportHandler::TOutputReport *FfbReportHandler::GetOutputReport(uint8_t reportId)
+{
+  // indexed by report ID, IDs the descriptor does not declare have no handler
+  static constexpr TOutputReport outputReports[] = {
+      {0, false, nullptr},
+      {sizeof(USB_FFBReport_SetEffect_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetEffect(&report.setEffect); }},
+      {sizeof(USB_FFBReport_SetEnvelope_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.SetEnvelope(&report.setEnvelope); }},
+      {sizeof(USB_FFBReport_SetCondition_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.SetCondition(&report.setCondition); }},
+      {sizeof(USB_FFBReport_SetPeriodic_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.SetPeriodic(&report.setPeriodic); }},
+      {sizeof(USB_FFBReport_SetConstantForce_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.SetConstantForce(&report.setConstantForce); }},
+      {sizeof(USB_FFBReport_SetRampForce_Output_Data_t), true, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.SetRampForce(&report.setRampForce); }},
+      {sizeof(USB_FFBReport_SetCustomForceData_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetCustomForceData(&report.setCustomForceData); }},
+      {sizeof(USB_FFBReport_SetDownloadForceSample_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t time)
+       { handler.FfbHandle_SetDownloadForceSample(&report.setDownloadForceSample, time); }},
+      {0, false, nullptr}, // 9 is not declared
+      {sizeof(USB_FFBReport_EffectOperation_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t time)
+       { handler.FfbHandle_EffectOperation(&report.effectOperation, time); }},
+      {sizeof(USB_FFBReport_BlockFree_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_BlockFree(&report.blockFree); }},
+      {sizeof(USB_FFBReport_DeviceControl_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t time)
+       { handler.FfbHandle_DeviceControl(&report.deviceControl, time); }},
+      {sizeof(USB_FFBReport_DeviceGain_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_DeviceGain(&report.deviceGain); }},
+      {sizeof(USB_FFBReport_SetCustomForce_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetCustomForce(&report.setCustomForce); }},
+      {sizeof(USB_FFBReport_TimedEffectOperation_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t time)
+       { handler.FfbHandle_TimedEffectOperation(&report.timedEffectOperation, time); }},
+      {sizeof(USB_FFBReport_BulkUpdate_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_BulkUpdate(&report.bulkUpdate); }},
+      {sizeof(USB_FFBReport_SetTimeline_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetTimeline(&report.setTimeline); }},
+      {sizeof(USB_FFBReport_TimelineOperation_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t time)
+       { handler.FfbHandle_TimelineOperation(&report.timelineOperation, time); }},
+      {sizeof(USB_FFBReport_SetModulation_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetModulation(&report.setModulation); }},
+      {sizeof(USB_FFBReport_SetWavetableData_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetWavetableData(&report.setWavetableData); }},
+      {sizeof(USB_FFBReport_SetResponseCurve_Output_Data_t), false, [](FfbReportHandler &handler, TOutputReportData &report, uint64_t)
+       { handler.FfbHandle_SetResponseCurve(&report.setResponseCurve); }},
+  };
+  static_assert(sizeof(outputReports) / sizeof(outputReports[0]) == SET_RESPONSE_CURVE_REPORT + 1, "one entry per output report ID");
+
+  if (reportId >= sizeof(outputReports) / sizeof(outputReports[0]) || outputReports[reportId].dispatch == nullptr)
+    return nullptr;
+  return &outputReports[reportId];
+}
+
+void FfbReportHandler::DispatchReport(const TOutputReport *report, const uint8_t *data, uint64_t time)
+{
+  if (coalescing && report->coalesce)
+  {
+    QueueReport(report, data);
+    return;
+  }
+  // bulk updates wait for the tick as well, everything else must see the updates sent before it
+  bool staged = data[0] == SET_BULK_UPDATE_REPORT;
+  if (!staged)
+    FlushPendingReports();
+
+  // streamed samples bypass the effects, so they leave cached effect forces valid
+  if (!staged && data[0] != SET_DOWNLOAD_FORCE_SAMPLE_REPORT)
+    ++revision;
+  // the report structs are packed, so the handlers read batched reports at any offset in place, they do not write them
+  static_assert(alignof(TOutputReportData) == 1, "output reports are read in place");
+  report->dispatch(*this, *(TOutputReportData *)data, time);
+}
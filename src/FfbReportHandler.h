@@ -28,11 +28,14 @@
 #define FFBHANDLER_h
 
 #include "HIDReportType.h"
+#include "FfbScheduler.h"
+#include "FfbForceStream.h"
+#include "FfbSequencer.h"
 
 class FfbReportHandler
 {
 public:
-  FfbReportHandler(uint64_t (*)(void));
+  FfbReportHandler(uint64_t (*)(void) = nullptr);
   ~FfbReportHandler();
 
   uint8_t *FfbOnPIDPool();
@@ -41,31 +44,125 @@ public:
 
   // Handle incoming data from USB
   void FfbOnCreateNewEffect(USB_FFBReport_CreateNewEffect_Feature_Data_t *inData);
+  // Without a clock callback the overloads without time use the last time passed to one with time
   void FfbOnUsbData(uint8_t *data, uint16_t len);
-  const TEffectState *GetEffectStates();
+  // Same as above, but with the device time supplied by the caller instead of read from the clock callback
+  void FfbOnUsbData(uint8_t *data, uint16_t len, uint64_t time);
+  // Handles output reports concatenated in one buffer, stops at the first unknown or truncated report.
+  // Returns the number of reports handled.
+  uint16_t FfbOnUsbBatch(const uint8_t *data, uint16_t len);
+  uint16_t FfbOnUsbBatch(const uint8_t *data, uint16_t len, uint64_t time);
+  // With coalescing, effect parameter reports wait until the next tick and a newer copy for the same effect
+  // parameter replaces the pending one. Any other report but a bulk update applies the pending ones first.
+  void SetCoalescing(bool enable);
+  // Applies pending parameter reports, the engine calls it at every tick and any report but a bulk update before it runs
+  void FlushPendingReports();
+  // Applies the bulk updates staged since the last tick, only the engine calls it at every tick
+  void ApplyBulkUpdates();
+  const TEffectState *GetEffectStates() const;
+  // Effect clock: device time with all paused intervals removed. It stands still while paused.
+  uint64_t GetEffectTime(uint64_t deviceTime) const;
+  // Arms and disarms trigger button effects on button edges, time is effect time
+  void UpdateTriggers(uint8_t buttons, uint8_t pressed, uint8_t released, uint64_t time);
+  // Starts and expires effects whose deadlines passed by the given effect time
+  bool AdvanceEffects(uint64_t time);
+  const uint8_t *GetActiveEffects(uint8_t &count) const;
+  // Changes whenever effect parameters, play state or the active effects change
+  uint32_t GetRevision() const;
+  // Samples of a custom force effect, nullptr if no samples were downloaded for it
+  const TCustomForce *GetCustomForce(uint8_t effectIdx) const;
+  // Points of a wavetable effect, nullptr if no table was uploaded for it
+  const TWavetable *GetWavetable(uint8_t effectIdx) const;
+  // Response curve of a condition block, nullptr if the block is linear
+  const TResponseCurve *GetResponseCurve(uint8_t effectIdx, uint8_t parameterBlockOffset) const;
+  bool HasResponseCurve(uint8_t effectIdx) const;
+  // Modulation routes by slot, activeCount is 0 when no route is set
+  const TModulation *GetModulations(uint8_t &activeCount) const;
+  // Device time of the next effect start or stop, timeline step or timed operation, FFB_TIME_NEVER if nothing is due.
+  // Effects do not start or stop and timelines do not advance while the device is paused.
+  uint64_t GetNextDeadline() const;
+  // Applies timed effect operations whose apply time passed by the given device time, the engine calls it at every tick
+  void ApplyTimedOperations(uint64_t deviceTime);
+  // Applies the timeline steps that fell due by the given effect time
+  void AdvanceTimelines(uint64_t time);
+  // Playout of streamed Download Force Sample reports, see FfbForceStream
+  void SetStreamPlayout(uint16_t delay, uint16_t holdTime, uint16_t decayTime);
+  // Adds the streamed force playing at device time
+  void AddStreamForce(uint64_t deviceTime, float force[NUM_AXES]) const;
 
   volatile uint8_t devicePaused;
   uint8_t deviceGain = USB_MAX_GAIN;
 
 private:
+  typedef union
+  {
+    USB_FFBReport_SetEffect_Output_Data_t setEffect;
+    USB_FFBReport_SetEnvelope_Output_Data_t setEnvelope;
+    USB_FFBReport_SetCondition_Output_Data_t setCondition;
+    USB_FFBReport_SetPeriodic_Output_Data_t setPeriodic;
+    USB_FFBReport_SetConstantForce_Output_Data_t setConstantForce;
+    USB_FFBReport_SetRampForce_Output_Data_t setRampForce;
+    USB_FFBReport_SetCustomForceData_Output_Data_t setCustomForceData;
+    USB_FFBReport_SetDownloadForceSample_Output_Data_t setDownloadForceSample;
+    USB_FFBReport_EffectOperation_Output_Data_t effectOperation;
+    USB_FFBReport_BlockFree_Output_Data_t blockFree;
+    USB_FFBReport_DeviceControl_Output_Data_t deviceControl;
+    USB_FFBReport_DeviceGain_Output_Data_t deviceGain;
+    USB_FFBReport_SetCustomForce_Output_Data_t setCustomForce;
+    USB_FFBReport_TimedEffectOperation_Output_Data_t timedEffectOperation;
+    USB_FFBReport_BulkUpdate_Output_Data_t bulkUpdate;
+    USB_FFBReport_SetTimeline_Output_Data_t setTimeline;
+    USB_FFBReport_TimelineOperation_Output_Data_t timelineOperation;
+    USB_FFBReport_SetModulation_Output_Data_t setModulation;
+    USB_FFBReport_SetWavetableData_Output_Data_t setWavetableData;
+    USB_FFBReport_SetResponseCurve_Output_Data_t setResponseCurve;
+  } TOutputReportData;
+
+  typedef struct
+  {
+    uint8_t size;
+    bool coalesce;
+    void (*dispatch)(FfbReportHandler &, TOutputReportData &, uint64_t time);
+  } TOutputReport;
+
+  static const TOutputReport *GetOutputReport(uint8_t reportId);
+  void DispatchReport(const TOutputReport *report, const uint8_t *data, uint64_t time);
+  void QueueReport(const TOutputReport *report, const uint8_t *data);
+
   // ffb state structures
   uint8_t GetNextFreeEffect(void);
-  void StartEffect(TEffectState *);
+  void StartEffect(TEffectState *, uint64_t time);
+  void ScheduleEffect(TEffectState *);
+  void ArmTriggerEffect(TEffectState *, uint64_t time);
   void StopEffect(TEffectState *);
   void StopAllEffects(void);
   void FreeEffect(uint8_t id);
   void FreeAllEffects(void);
 
   TEffectState *GetEffect(uint8_t id);
+  TCustomForce *AllocateCustomForce(uint8_t effectIdx);
+  void FreeCustomForce(uint8_t effectIdx);
+  TWavetable *AllocateWavetable(uint8_t effectIdx);
+  void FreeWavetable(uint8_t effectIdx);
+  void FreeResponseCurves(uint8_t effectIdx);
 
   // handle output report
-  void FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_Output_Data_t *data);
+  void FfbHandle_EffectOperation(USB_FFBReport_EffectOperation_Output_Data_t *data, uint64_t time);
   void FfbHandle_BlockFree(USB_FFBReport_BlockFree_Output_Data_t *data);
-  void FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Output_Data_t *data);
+  void FfbHandle_DeviceControl(USB_FFBReport_DeviceControl_Output_Data_t *data, uint64_t time);
   void FfbHandle_DeviceGain(USB_FFBReport_DeviceGain_Output_Data_t *data);
   void FfbHandle_SetCustomForceData(USB_FFBReport_SetCustomForceData_Output_Data_t *data);
-  void FfbHandle_SetDownloadForceSample(USB_FFBReport_SetDownloadForceSample_Output_Data_t *data);
+  void FfbHandle_SetDownloadForceSample(USB_FFBReport_SetDownloadForceSample_Output_Data_t *data, uint64_t time);
   void FfbHandle_SetCustomForce(USB_FFBReport_SetCustomForce_Output_Data_t *data);
+  void FfbHandle_TimedEffectOperation(USB_FFBReport_TimedEffectOperation_Output_Data_t *data, uint64_t time);
+  void FfbHandle_BulkUpdate(USB_FFBReport_BulkUpdate_Output_Data_t *data);
+  void FfbHandle_SetTimeline(USB_FFBReport_SetTimeline_Output_Data_t *data);
+  void FfbHandle_TimelineOperation(USB_FFBReport_TimelineOperation_Output_Data_t *data, uint64_t time);
+  void FfbHandle_SetModulation(USB_FFBReport_SetModulation_Output_Data_t *data);
+  void FfbHandle_SetWavetableData(USB_FFBReport_SetWavetableData_Output_Data_t *data);
+  void FfbHandle_SetResponseCurve(USB_FFBReport_SetResponseCurve_Output_Data_t *data);
+  // parameter is BULK_UPDATE_MAGNITUDE or BULK_UPDATE_OFFSET, effects without it are left alone
+  void SetEffectParameter(TEffectState &effectState, uint8_t parameter, int16_t value);
   void FfbHandle_SetEffect(USB_FFBReport_SetEffect_Output_Data_t *data);
   void SetEnvelope(USB_FFBReport_SetEnvelope_Output_Data_t *data);
   void SetCondition(USB_FFBReport_SetCondition_Output_Data_t *data);
@@ -74,9 +171,50 @@ private:
   void SetRampForce(USB_FFBReport_SetRampForce_Output_Data_t *data);
 
   TEffectState gEffectStates[MAX_EFFECTS];
+  TCustomForce customForces[FFB_MAX_CUSTOM_EFFECTS];
+  TWavetable wavetables[FFB_MAX_WAVETABLES];
+  TResponseCurve responseCurves[FFB_MAX_RESPONSE_CURVES];
+  TModulation modulations[FFB_MAX_MODULATIONS];
+  uint8_t modulationCount = 0;
+  FfbScheduler scheduler;
+  FfbForceStream forceStream;
+  FfbSequencer sequencer;
+
+  typedef struct
+  {
+    uint32_t key; // report ID, effect block index and parameter block offset
+    TOutputReportData data;
+  } TPendingReport;
+
+  typedef struct
+  {
+    uint64_t time; // device time
+    USB_FFBReport_EffectOperation_Output_Data_t operation;
+  } TTimedOperation;
+
+  TTimedOperation timedOperations[FFB_MAX_TIMED_OPERATIONS]; // ordered by time
+  uint8_t timedOperationCount = 0;
+
+  typedef struct
+  {
+    uint8_t parameters; // bits: BULK_UPDATE_MAGNITUDE, BULK_UPDATE_OFFSET
+    int16_t magnitude;
+    int16_t offset;
+  } TBulkUpdate;
+
+  // bulk updates staged per effect until the next tick
+  TBulkUpdate bulkUpdates[MAX_EFFECTS];
+  bool bulkUpdatePending = false;
+
+  TPendingReport pendingReports[FFB_MAX_PENDING_REPORTS];
+  uint8_t pendingCount = 0;
+  bool coalescing = false;
 
   // Effect management
   uint64_t pauseTime;
+  uint64_t pausedDuration;
+  uint8_t triggerButtons;
+  uint32_t revision = 0;
 
   // variables for storing previous values
   volatile USB_FFBReport_PIDStatus_Input_Data_t pidState = {2, 30, 0};
@@ -84,6 +222,8 @@ private:
   volatile USB_FFBReport_PIDPool_Feature_Data_t pidPoolReport;
   // pointer to function providing current time in miliseconds
   uint64_t (*getTimeMilli)(void);
+  uint64_t lastTime = 0;
+  uint64_t GetTime();
 };
 
 extern FfbReportHandler ffbReportHandler;
@@ -0,0 +1,199 @@
+/*
+  Force Feedback Joystick
+  Deadline scheduler for effect start and stop times.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#include "FfbScheduler.h"
+
+#define HEAP_POSITION_NONE 0xFF
+
+FfbScheduler::FfbScheduler()
+{
+  Reset();
+}
+
+void FfbScheduler::Reset()
+{
+  heapSize = 0;
+  activeCount = 0;
+  for (uint8_t idx = 0; idx < MAX_EFFECTS; ++idx)
+  {
+    heapPosition[idx] = HEAP_POSITION_NONE;
+    active[idx] = false;
+  }
+}
+
+void FfbScheduler::Schedule(uint8_t effectIdx, uint64_t start, uint64_t stop, uint32_t period)
+{
+  if (effectIdx >= MAX_EFFECTS)
+    return;
+
+  Remove(effectIdx);
+  windows[effectIdx].start = start;
+  windows[effectIdx].stop = stop;
+  windows[effectIdx].period = (stop == FFB_TIME_NEVER) ? 0 : period;
+  HeapPush(effectIdx, start);
+}
+
+void FfbScheduler::Remove(uint8_t effectIdx)
+{
+  if (effectIdx >= MAX_EFFECTS)
+    return;
+
+  if (heapPosition[effectIdx] != HEAP_POSITION_NONE)
+    HeapRemove(heapPosition[effectIdx]);
+
+  if (active[effectIdx])
+    Deactivate(effectIdx);
+}
+
+bool FfbScheduler::Advance(uint64_t time)
+{
+  bool changed = false;
+  while (heapSize > 0 && heap[0].time <= time)
+  {
+    uint8_t effectIdx = heap[0].effectIdx;
+    HeapRemove(0);
+    changed = true;
+
+    TWindow &window = windows[effectIdx];
+    if (active[effectIdx])
+    {
+      Deactivate(effectIdx);
+      if (window.period == 0)
+        continue;
+
+      // next repetition, skipping the windows that already passed completely
+      uint64_t skip = (time - window.stop) / window.period + 1;
+      window.start += skip * window.period;
+      window.stop += skip * window.period;
+      HeapPush(effectIdx, window.start);
+      continue;
+    }
+
+    Activate(effectIdx);
+    if (window.stop != FFB_TIME_NEVER)
+      HeapPush(effectIdx, window.stop);
+  }
+  return changed;
+}
+
+bool FfbScheduler::IsActive(uint8_t effectIdx) const
+{
+  return effectIdx < MAX_EFFECTS && active[effectIdx];
+}
+
+const uint8_t *FfbScheduler::GetActiveEffects(uint8_t &count) const
+{
+  count = activeCount;
+  return activeEffects;
+}
+
+uint64_t FfbScheduler::GetNextDeadline() const
+{
+  if (heapSize == 0)
+    return FFB_TIME_NEVER;
+  return heap[0].time;
+}
+
+void FfbScheduler::Activate(uint8_t effectIdx)
+{
+  uint8_t position = activeCount;
+  while (position > 0 && activeEffects[position - 1] > effectIdx)
+  {
+    activeEffects[position] = activeEffects[position - 1];
+    --position;
+  }
+  activeEffects[position] = effectIdx;
+  ++activeCount;
+  active[effectIdx] = true;
+}
+
+void FfbScheduler::Deactivate(uint8_t effectIdx)
+{
+  uint8_t position = 0;
+  while (activeEffects[position] != effectIdx)
+    ++position;
+
+  for (--activeCount; position < activeCount; ++position)
+    activeEffects[position] = activeEffects[position + 1];
+  active[effectIdx] = false;
+}
+
+void FfbScheduler::HeapPush(uint8_t effectIdx, uint64_t time)
+{
+  uint8_t position = heapSize++;
+  heap[position].time = time;
+  heap[position].effectIdx = effectIdx;
+  heapPosition[effectIdx] = position;
+  HeapSiftUp(position);
+}
+
+void FfbScheduler::HeapRemove(uint8_t position)
+{
+  heapPosition[heap[position].effectIdx] = HEAP_POSITION_NONE;
+  if (--heapSize == position)
+    return;
+
+  uint8_t moved = heap[heapSize].effectIdx;
+  heap[position] = heap[heapSize];
+  heapPosition[moved] = position;
+  HeapSiftUp(position);
+  HeapSiftDown(heapPosition[moved]);
+}
+
+void FfbScheduler::HeapSiftUp(uint8_t position)
+{
+  while (position > 0)
+  {
+    uint8_t parent = (position - 1) / 2;
+    if (heap[parent].time <= heap[position].time)
+      break;
+    HeapSwap(parent, position);
+    position = parent;
+  }
+}
+
+void FfbScheduler::HeapSiftDown(uint8_t position)
+{
+  for (;;)
+  {
+    uint16_t smallest = position;
+    uint16_t left = 2 * position + 1;
+    uint16_t right = left + 1;
+    if (left < heapSize && heap[left].time < heap[smallest].time)
+      smallest = left;
+    if (right < heapSize && heap[right].time < heap[smallest].time)
+      smallest = right;
+    if (smallest == position)
+      break;
+    HeapSwap(position, smallest);
+    position = smallest;
+  }
+}
+
+void FfbScheduler::HeapSwap(uint8_t a, uint8_t b)
+{
+  TDeadline temp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = temp;
+  heapPosition[heap[a].effectIdx] = a;
+  heapPosition[heap[b].effectIdx] = b;
+}
@@ -0,0 +1,83 @@
+/*
+  Force Feedback Joystick
+  Deadline scheduler for effect start and stop times.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBSCHEDULER_h
+#define FFBSCHEDULER_h
+
+#include "HIDReportType.h"
+
+#define FFB_TIME_NEVER UINT64_MAX
+
+// Keeps every scheduled effect either pending (waiting for its start time) or active (waiting for its stop time).
+// Each effect has at most one deadline in a binary min-heap, so a tick only pops the deadlines that have passed.
+class FfbScheduler
+{
+public:
+  FfbScheduler();
+
+  void Reset();
+  // effect is active in [start, stop), stop = FFB_TIME_NEVER plays until removed
+  // a non zero period repeats the window every period until removed
+  void Schedule(uint8_t effectIdx, uint64_t start, uint64_t stop, uint32_t period = 0);
+  void Remove(uint8_t effectIdx);
+  // moves effects whose deadlines passed, returns true when the active set changed
+  bool Advance(uint64_t time);
+
+  bool IsActive(uint8_t effectIdx) const;
+  // active effect indices in ascending order
+  const uint8_t *GetActiveEffects(uint8_t &count) const;
+  uint64_t GetNextDeadline() const;
+
+private:
+  void HeapPush(uint8_t effectIdx, uint64_t time);
+  void HeapRemove(uint8_t position);
+  void HeapSiftUp(uint8_t position);
+  void HeapSiftDown(uint8_t position);
+  void HeapSwap(uint8_t a, uint8_t b);
+  void Activate(uint8_t effectIdx);
+  void Deactivate(uint8_t effectIdx);
+
+  typedef struct
+  {
+    uint64_t time;
+    uint8_t effectIdx;
+  } TDeadline;
+
+  TDeadline heap[MAX_EFFECTS];
+  uint8_t heapSize;
+  uint8_t heapPosition[MAX_EFFECTS]; // position of the effect's deadline in the heap
+
+  typedef struct
+  {
+    uint64_t start;
+    uint64_t stop;
+    uint32_t period;
+  } TWindow;
+
+  TWindow windows[MAX_EFFECTS];
+
+  uint8_t activeEffects[MAX_EFFECTS];
+  uint8_t activeCount;
+  bool active[MAX_EFFECTS];
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*
+  Force Feedback Joystick
+  Device resident timelines of effect operations and parameter changes.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#include "FfbSequencer.h"
+#include <string.h>
+
+FfbSequencer::FfbSequencer()
+{
+  Reset();
+}
+
+void FfbSequencer::Reset()
+{
+  memset(timelines, 0, sizeof(timelines));
+}
+
+void FfbSequencer::SetSteps(uint8_t timelineIdx, uint8_t stepOffset, uint8_t stepCount, uint16_t loopPeriod,
+                            const USB_FFBReport_TimelineStep_t *steps, uint8_t count)
+{
+  if (timelineIdx >= FFB_MAX_TIMELINES || stepOffset >= FFB_TIMELINE_MAX_STEPS)
+    return;
+
+  // a running timeline would continue with a mix of old and new steps
+  TTimeline &timeline = timelines[timelineIdx];
+  timeline.running = false;
+  timeline.stepCount = stepCount < FFB_TIMELINE_MAX_STEPS ? stepCount : FFB_TIMELINE_MAX_STEPS;
+  timeline.loopPeriod = loopPeriod;
+  if (count > FFB_TIMELINE_MAX_STEPS - stepOffset)
+    count = FFB_TIMELINE_MAX_STEPS - stepOffset;
+  memcpy(&timeline.steps[stepOffset], steps, count * sizeof(USB_FFBReport_TimelineStep_t));
+}
+
+void FfbSequencer::Start(uint8_t timelineIdx, uint64_t time)
+{
+  if (timelineIdx >= FFB_MAX_TIMELINES || timelines[timelineIdx].stepCount == 0)
+    return;
+
+  TTimeline &timeline = timelines[timelineIdx];
+  timeline.running = true;
+  timeline.cycleStart = time;
+  timeline.nextStep = 0;
+}
+
+void FfbSequencer::Stop(uint8_t timelineIdx)
+{
+  if (timelineIdx < FFB_MAX_TIMELINES)
+    timelines[timelineIdx].running = false;
+}
+
+bool FfbSequencer::IsRunning(uint8_t timelineIdx) const
+{
+  return timelineIdx < FFB_MAX_TIMELINES && timelines[timelineIdx].running;
+}
+
+uint64_t FfbSequencer::GetDueTime(const TTimeline &timeline) const
+{
+  if (!timeline.running)
+    return FFB_TIME_NEVER;
+  return timeline.cycleStart + timeline.steps[timeline.nextStep].time;
+}
+
+bool FfbSequencer::NextStep(uint64_t time, USB_FFBReport_TimelineStep_t &step, uint64_t &dueTime)
+{
+  TTimeline *earliest = nullptr;
+  dueTime = FFB_TIME_NEVER;
+  for (uint8_t idx = 0; idx < FFB_MAX_TIMELINES; ++idx)
+  {
+    uint64_t stepTime = GetDueTime(timelines[idx]);
+    if (stepTime <= time && stepTime < dueTime)
+    {
+      earliest = &timelines[idx];
+      dueTime = stepTime;
+    }
+  }
+  if (earliest == nullptr)
+    return false;
+
+  TTimeline &timeline = *earliest;
+  step = timeline.steps[timeline.nextStep];
+  if (++timeline.nextStep < timeline.stepCount)
+    return true;
+
+  timeline.nextStep = 0;
+  if (timeline.loopPeriod == 0)
+  {
+    timeline.running = false;
+    return true;
+  }
+  timeline.cycleStart += timeline.loopPeriod;
+  if (timeline.cycleStart + timeline.loopPeriod <= time)
+    timeline.cycleStart += (time - timeline.cycleStart) / timeline.loopPeriod * timeline.loopPeriod;
+  return true;
+}
+
+uint64_t FfbSequencer::GetNextDeadline() const
+{
+  uint64_t deadline = FFB_TIME_NEVER;
+  for (uint8_t idx = 0; idx < FFB_MAX_TIMELINES; ++idx)
+  {
+    uint64_t stepTime = GetDueTime(timelines[idx]);
+    if (stepTime < deadline)
+      deadline = stepTime;
+  }
+  return deadline;
+}
@@ -0,0 +1,64 @@
+/*
+  Force Feedback Joystick
+  Device resident timelines of effect operations and parameter changes.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBSEQUENCER_h
+#define FFBSEQUENCER_h
+
+#include "HIDReportType.h"
+#include "FfbScheduler.h"
+
+// Stores timelines of (time, effect block, action) steps and hands out the steps as they fall due.
+// A looping timeline restarts every loop period, whole periods missed by a late tick are skipped.
+class FfbSequencer
+{
+public:
+  FfbSequencer();
+
+  void Reset();
+  // writes count steps from stepOffset on, stepCount is the length of the whole timeline
+  void SetSteps(uint8_t timelineIdx, uint8_t stepOffset, uint8_t stepCount, uint16_t loopPeriod,
+                const USB_FFBReport_TimelineStep_t *steps, uint8_t count);
+  void Start(uint8_t timelineIdx, uint64_t time);
+  void Stop(uint8_t timelineIdx);
+  bool IsRunning(uint8_t timelineIdx) const;
+
+  // Takes the earliest step that is due by time, dueTime is when it was due. Returns false when none is due.
+  bool NextStep(uint64_t time, USB_FFBReport_TimelineStep_t &step, uint64_t &dueTime);
+  uint64_t GetNextDeadline() const;
+
+private:
+  typedef struct
+  {
+    USB_FFBReport_TimelineStep_t steps[FFB_TIMELINE_MAX_STEPS];
+    uint8_t stepCount;
+    uint16_t loopPeriod;
+    bool running;
+    uint64_t cycleStart;
+    uint8_t nextStep;
+  } TTimeline;
+
+  uint64_t GetDueTime(const TTimeline &timeline) const;
+
+  TTimeline timelines[FFB_MAX_TIMELINES];
+};
+
+#endif
@@ -26,7 +26,13 @@
 #ifndef FFBWHEELDESCRIPTOR_H
 #define FFBWHEELDESCRIPTOR_H
 
+#include "HIDReportType.h"
+
 #define HID_REPORTID_WHEEL 0x01
+// Effect block index range follows MAX_EFFECTS, two byte items keep values above 127 positive
+#define HID_MAX_EFFECTS (MAX_EFFECTS & 0xFF), 0x00
+// PID state report carries the effect block index in 7 bits
+#define HID_PID_STATE_MAX_EFFECTS (MAX_EFFECTS > 127 ? 127 : MAX_EFFECTS)
 static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x05, 0x01, // USAGE_PAGE (Generic Desktop)
     0x09, 0x04, // USAGE (Joystick)
@@ -92,9 +98,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x81, 0x02, //  Input (variable,absolute)
     0x09, 0x22, //  Usage (Effect Block Index)
     0x15, 0x01, //  Logical Minimum (1)
-    0x25, 0x28, //  Logical Maximum (40)
+    0x25, HID_PID_STATE_MAX_EFFECTS, //  Logical Maximum (MAX_EFFECTS, 7 bits)
     0x35, 0x01, //  Physical Minimum (1)
-    0x45, 0x28, //  Physical Maximum (40)
+    0x45, HID_PID_STATE_MAX_EFFECTS, //  Physical Maximum (MAX_EFFECTS, 7 bits)
     0x75, 0x07, //  Report Size (7)
     0x95, 0x01, //  Report Count (1)
     0x81, 0x02, //  Input (variable,absolute)
@@ -108,9 +114,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x01,       // Report ID 1
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -128,11 +134,12 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x09, 0x42,       // USAGE (42)
     0x09, 0x43,       // USAGE (43)
     0x09, 0x28,       // USAGE (28)
+    0x0B, 0x40, 0x00, 0x00, 0xFF, // USAGE (Vendor Defined 0xFF00:40, ET Wavetable)
     0x09, 0x28,       //      Usage (ET Custom Force Data)
     0x15, 0x01,       //       Logical Minimum (1)
-    0x25, 0x0C,       //       Logical Maximum (12)
+    0x25, 0x0D,       //       Logical Maximum (13)
     0x35, 0x01,       //       Physical Minimum (1)
-    0x45, 0x0C,       //       Physical Maximum (12)
+    0x45, 0x0D,       //       Physical Maximum (13)
     0x75, 0x08,       //       Report Size (8)
     0x95, 0x01,       //       Report Count (1)
     0x91, 0x00,       //       Output (Data)
@@ -222,9 +229,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x02,             // Report ID 2
     0x09, 0x22,             //  Usage (Effect Block Index)
     0x15, 0x01,             //   Logical Minimum (1)
-    0x25, 0x28,             //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,             //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,             //   Physical Minimum (1)
-    0x45, 0x28,             //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,             //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,             //   Report Size (8)
     0x95, 0x01,             //   Report Count (1)
     0x91, 0x02,             //   Output (Data,Var,Abs)
@@ -241,9 +248,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x09, 0x5E,             //  Usage (Fade Time)
     0x66, 0x03, 0x10,       //   Unit (1003h) English Linear, Seconds
     0x55, 0xFD,             //   Unit Exponent (FDh) (X10^-3 ==> Milisecond)
-    0x27, 0xFF, 0x7F, 0, 0, //   Logical Maximum (4294967295)
-    0x47, 0xFF, 0x7F, 0, 0, //   Physical Maximum (4294967295)
-    0x75, 0x20,             //   Report Size (32)
+    0x27, 0xFF, 0x7F, 0, 0, //   Logical Maximum (32767)
+    0x47, 0xFF, 0x7F, 0, 0, //   Physical Maximum (32767)
+    0x75, 0x10,             //   Report Size (16)
     0x91, 0x02,             //   Output (Data,Var,Abs)
     0x45, 0x00,             //   Physical Maximum (0)
     0x66, 0x00, 0x00,       //   Unit (0)
@@ -256,9 +263,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x03,             // Report ID 3
     0x09, 0x22,             //  Usage (Effect Block Index)
     0x15, 0x01,             //   Logical Minimum (1)
-    0x25, 0x28,             //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,             //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,             //   Physical Minimum (1)
-    0x45, 0x28,             //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,             //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,             //   Report Size (8)
     0x95, 0x01,             //   Report Count (1)
     0x91, 0x02,             //   Output (Data,Var,Abs)
@@ -313,9 +320,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x04,       // Report ID 4
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -353,7 +360,7 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x47, 0xFF, 0x7F, 0, 0, //   Physical Maximum (32K)
     0x66, 0x03, 0x10,       //   Unit (1003h) (English Linear, Seconds)
     0x55, 0xFD,             //   Unit Exponent (FDh) (X10^-3 ==> Milisecond)
-    0x75, 0x20,             //   Report Size (32)
+    0x75, 0x10,             //   Report Size (16)
     0x95, 0x01,             //   Report Count (1)
     0x91, 0x02,             //   Output (Data,Var,Abs)
     0x66, 0x00, 0x00,       //  Unit (0)
@@ -366,9 +373,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x05,       // Report ID 5
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -388,9 +395,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x06,       // Report ID 6
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -411,9 +418,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x07,       // Report ID 7
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -458,9 +465,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x0A,       // Report ID 10
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -489,9 +496,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x0B, // Report ID 11
     0x09, 0x22, //  Usage (Effect Block Index)
     0x15, 0x01, //   Logical Minimum (1)
-    0x25, 0x28, //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS, //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01, //   Physical Minimum (1)
-    0x45, 0x28, //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS, //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08, //   Report Size (8)
     0x95, 0x01, //   Report Count (1)
     0x91, 0x02, //   Output (Data,Var,Abs)
@@ -533,9 +540,9 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x85, 0x0E,       // Report ID 14
     0x09, 0x22,       //  Usage (Effect Block Index)
     0x15, 0x01,       //   Logical Minimum (1)
-    0x25, 0x28,       //   Logical Maximum (40)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
     0x35, 0x01,       //   Physical Minimum (1)
-    0x45, 0x28,       //   Physical Maximum (40)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
     0x75, 0x08,       //   Report Size (8)
     0x95, 0x01,       //   Report Count (1)
     0x91, 0x02,       //   Output (Data,Var,Abs)
@@ -561,6 +568,245 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x66, 0x00, 0x00, //   Unit 0
     0xC0,             // End Collection Datalink (Logical) (OK)
 
+    // TimedEffectOperationReport (vendor defined)
+    0x06, 0x00, 0xFF, // Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x01,       // Usage (Timed Effect Operation Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x0F,       // Report ID 15
+    0x09, 0x02,       //  Usage (Effect Block Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x03,       //  Usage (Effect Operation)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x25, 0x03,       //   Logical Maximum (3)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x45, 0x03,       //   Physical Maximum (3)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x04,       //  Usage (Loop Count)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x00, //   Logical Maximum (255)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0xFF, 0x00, //   Physical Maximum (255)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x05,       //  Usage (Apply Time, low 32 bits of device time)
+    0x66, 0x03, 0x10, //   Unit 4099
+    0x55, 0xFD,       //   Unit (Exponent 253)
+    0x17, 0x00, 0x00, 0x00, 0x80, //   Logical Minimum (-2147483648)
+    0x27, 0xFF, 0xFF, 0xFF, 0x7F, //   Logical Maximum (2147483647)
+    0x37, 0x00, 0x00, 0x00, 0x80, //   Physical Minimum (-2147483648)
+    0x47, 0xFF, 0xFF, 0xFF, 0x7F, //   Physical Maximum (2147483647)
+    0x75, 0x20,       //   Report Size (32)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x55, 0x00,       //   Unit (Exponent 0)
+    0x66, 0x00, 0x00, //   Unit 0
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // BulkUpdateReport (vendor defined)
+    0x09, 0x10,       // Usage (Bulk Update Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x10,       // Report ID 16
+    0x09, 0x11,       //  Usage (Entry Count)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, FFB_BULK_UPDATE_ENTRIES, //   Logical Maximum (FFB_BULK_UPDATE_ENTRIES)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x45, FFB_BULK_UPDATE_ENTRIES, //   Physical Maximum (FFB_BULK_UPDATE_ENTRIES)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x12,       //  Usage (Entries: effect block index, parameter, 16 bit value)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x00, //   Logical Maximum (255)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0xFF, 0x00, //   Physical Maximum (255)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, FFB_BULK_UPDATE_ENTRIES * 4, //   Report Count (FFB_BULK_UPDATE_ENTRIES * 4)
+    0x92, 0x02, 0x01, //   Output (Data,Var,Abs,Buffered Bytes)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // SetTimelineReport (vendor defined)
+    0x09, 0x20,       // Usage (Set Timeline Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x11,       // Report ID 17
+    0x09, 0x21,       //  Usage (Timeline Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x25, FFB_MAX_TIMELINES, //   Logical Maximum (FFB_MAX_TIMELINES)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x45, FFB_MAX_TIMELINES, //   Physical Maximum (FFB_MAX_TIMELINES)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x22,       //  Usage (Step Offset)
+    0x09, 0x23,       //  Usage (Step Count)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, FFB_TIMELINE_MAX_STEPS, //   Logical Maximum (FFB_TIMELINE_MAX_STEPS)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x45, FFB_TIMELINE_MAX_STEPS, //   Physical Maximum (FFB_TIMELINE_MAX_STEPS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x02,       //   Report Count (2)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x24,       //  Usage (Loop Period)
+    0x66, 0x03, 0x10, //   Unit 4099
+    0x55, 0xFD,       //   Unit (Exponent 253)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x27, 0xFF, 0xFF, 0x00, 0x00, //   Logical Maximum (65535)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x47, 0xFF, 0xFF, 0x00, 0x00, //   Physical Maximum (65535)
+    0x75, 0x10,       //   Report Size (16)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x55, 0x00,       //   Unit (Exponent 0)
+    0x66, 0x00, 0x00, //   Unit 0
+    0x09, 0x25,       //  Usage (Steps: 16 bit time, effect block index, action, 16 bit value)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x00, //   Logical Maximum (255)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0xFF, 0x00, //   Physical Maximum (255)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, FFB_TIMELINE_STEPS_PER_REPORT * 6, //   Report Count (FFB_TIMELINE_STEPS_PER_REPORT * 6)
+    0x92, 0x02, 0x01, //   Output (Data,Var,Abs,Buffered Bytes)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // TimelineOperationReport (vendor defined)
+    0x09, 0x28,       // Usage (Timeline Operation Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x12,       // Report ID 18
+    0x09, 0x21,       //  Usage (Timeline Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x25, FFB_MAX_TIMELINES, //   Logical Maximum (FFB_MAX_TIMELINES)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x45, FFB_MAX_TIMELINES, //   Physical Maximum (FFB_MAX_TIMELINES)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x29,       //  Usage (Timeline Operation)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x25, 0x02,       //   Logical Maximum (2)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x45, 0x02,       //   Physical Maximum (2)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // SetModulationReport (vendor defined)
+    0x09, 0x30,       // Usage (Set Modulation Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x13,       // Report ID 19
+    0x09, 0x31,       //  Usage (Modulation Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x25, FFB_MAX_MODULATIONS, //   Logical Maximum (FFB_MAX_MODULATIONS)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x45, FFB_MAX_MODULATIONS, //   Physical Maximum (FFB_MAX_MODULATIONS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x32,       //  Usage (Source Effect Block Index)
+    0x09, 0x33,       //  Usage (Target Effect Block Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x02,       //   Report Count (2)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x34,       //  Usage (Depth)
+    0x16, 0x01, 0x80, //   Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F, //   Logical Maximum (32767)
+    0x36, 0x01, 0x80, //   Physical Minimum (-32767)
+    0x46, 0xFF, 0x7F, //   Physical Maximum (32767)
+    0x75, 0x10,       //   Report Size (16)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x35,       //  Usage (Destination: 0=Off, 1=Magnitude, 2=Offset, 3=Period)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x03,       //   Logical Maximum (3)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x45, 0x03,       //   Physical Maximum (3)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // SetWavetableDataReport (vendor defined)
+    0x09, 0x41,       // Usage (Set Wavetable Data Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x14,       // Report ID 20
+    0x09, 0x42,       //  Usage (Effect Block Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x43,       //  Usage (Point Count)
+    0x09, 0x44,       //  Usage (Data Offset)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x7F, //   Logical Maximum (32767)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0xFF, 0x7F, //   Physical Maximum (32767)
+    0x75, 0x10,       //   Report Size (16)
+    0x95, 0x02,       //   Report Count (2)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x45,       //  Usage (Points)
+    0x16, 0x01, 0x80, //   Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F, //   Logical Maximum (32767)
+    0x36, 0x01, 0x80, //   Physical Minimum (-32767)
+    0x46, 0xFF, 0x7F, //   Physical Maximum (32767)
+    0x75, 0x10,       //   Report Size (16)
+    0x95, FFB_WAVETABLE_POINTS_PER_REPORT, //   Report Count (FFB_WAVETABLE_POINTS_PER_REPORT)
+    0x92, 0x02, 0x01, //   Output (Data,Var,Abs,Buffered Bytes)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+
+    // SetResponseCurveReport (vendor defined)
+    0x09, 0x50,       // Usage (Set Response Curve Report)
+    0xA1, 0x02,       // Collection Datalink (Logical)
+    0x85, 0x15,       // Report ID 21
+    0x09, 0x51,       //  Usage (Effect Block Index)
+    0x15, 0x01,       //   Logical Minimum (1)
+    0x26, HID_MAX_EFFECTS,       //   Logical Maximum (MAX_EFFECTS)
+    0x35, 0x01,       //   Physical Minimum (1)
+    0x46, HID_MAX_EFFECTS,       //   Physical Maximum (MAX_EFFECTS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x52,       //  Usage (Parameter Block Offset)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x01,       //   Logical Maximum (1)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x45, 0x01,       //   Physical Maximum (1)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x53,       //  Usage (Point Count)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, FFB_RESPONSE_CURVE_MAX_POINTS, //   Logical Maximum (FFB_RESPONSE_CURVE_MAX_POINTS)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x45, FFB_RESPONSE_CURVE_MAX_POINTS, //   Physical Maximum (FFB_RESPONSE_CURVE_MAX_POINTS)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x91, 0x02,       //   Output (Data,Var,Abs)
+    0x09, 0x54,       //  Usage (Points)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x7F, //   Logical Maximum (32767)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0xFF, 0x7F, //   Physical Maximum (32767)
+    0x75, 0x10,       //   Report Size (16)
+    0x95, FFB_RESPONSE_CURVE_MAX_POINTS, //   Report Count (FFB_RESPONSE_CURVE_MAX_POINTS)
+    0x92, 0x02, 0x01, //   Output (Data,Var,Abs,Buffered Bytes)
+    0xC0,             // End Collection Datalink (Logical) (OK)
+    0x05, 0x0F,       // Usage Page (Physical Interface)
+
     //=========================================FeatureReport======================================//
 
     // CreateNewEffectReport
@@ -581,10 +827,11 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0x09, 0x42,       // USAGE (42)
     0x09, 0x43,       // USAGE (43)
     0x09, 0x28,       // USAGE (28)
-    0x25, 0x0C,       // LOGICAL_MAXIMUM (0C)
+    0x0B, 0x40, 0x00, 0x00, 0xFF, // USAGE (Vendor Defined 0xFF00:40, ET Wavetable)
+    0x25, 0x0D,       // LOGICAL_MAXIMUM (0D)
     0x15, 0x01,       // LOGICAL_MINIMUM (01)
     0x35, 0x01,       // PHYSICAL_MINIMUM (01)
-    0x45, 0x0C,       // PHYSICAL_MAXIMUM (0C)
+    0x45, 0x0D,       // PHYSICAL_MAXIMUM (0D)
     0x75, 0x08,       // REPORT_SIZE (08)
     0x95, 0x01,       // REPORT_COUNT (01)
     0xB1, 0x00,       // FEATURE (Data)
@@ -608,10 +855,10 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
     0xA1, 0x02,                   // COLLECTION (Logical)
     0x85, 0x06,                   // REPORT_ID (06)
     0x09, 0x22,                   // USAGE (Effect Block Index)
-    0x25, 0x28,                   // LOGICAL_MAXIMUM (28)
+    0x26, HID_MAX_EFFECTS,        // LOGICAL_MAXIMUM (MAX_EFFECTS)
     0x15, 0x01,                   // LOGICAL_MINIMUM (01)
     0x35, 0x01,                   // PHYSICAL_MINIMUM (01)
-    0x45, 0x28,                   // PHYSICAL_MAXIMUM (28)
+    0x46, HID_MAX_EFFECTS,        // PHYSICAL_MAXIMUM (MAX_EFFECTS)
     0x75, 0x08,                   // REPORT_SIZE (08)
     0x95, 0x01,                   // REPORT_COUNT (01)
     0xB1, 0x02,                   // FEATURE (Data,Var,Abs)
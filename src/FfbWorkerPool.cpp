@@ -0,0 +1,141 @@
+/*
+  Force Feedback Joystick
+  Fixed worker thread pool for host side simulations.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#include "FfbWorkerPool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+thread_local const FfbWorkerPool *FfbWorkerPool::currentPool = nullptr;
+
+FfbWorkerPool::FfbWorkerPool(uint16_t count, bool pinToCores) : workerCount{count}
+{
+  if (workerCount == 0)
+    workerCount = 1;
+  // 0 when the core count is unknown, the workers are not pinned then
+  unsigned int coreCount = std::thread::hardware_concurrency();
+
+  workers.reset(new std::thread[workerCount]);
+  for (uint16_t i = 0; i < workerCount; ++i)
+  {
+    workers[i] = std::thread(&FfbWorkerPool::WorkerLoop, this, i);
+
+#if defined(__linux__)
+    if (pinToCores && coreCount > 0)
+    {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(i % coreCount, &cpuSet);
+      pthread_setaffinity_np(workers[i].native_handle(), sizeof(cpu_set_t), &cpuSet);
+    }
+#endif
+  }
+}
+
+FfbWorkerPool::~FfbWorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  batchStart.notify_all();
+
+  for (uint16_t i = 0; i < workerCount; ++i)
+    workers[i].join();
+}
+
+uint16_t FfbWorkerPool::GetWorkerCount() const
+{
+  return workerCount;
+}
+
+void FfbWorkerPool::Run(void (*job)(void *, uint32_t), void *context, uint32_t jobCount)
+{
+  if (jobCount == 0)
+    return;
+
+  // the workers are busy with the outer batch, waiting for them would never return
+  if (currentPool == this)
+  {
+    for (uint32_t jobIdx = 0; jobIdx < jobCount; ++jobIdx)
+      job(context, jobIdx);
+    return;
+  }
+
+  // batches from other threads wait until the running one finished
+  std::unique_lock<std::mutex> lock(mutex);
+  batchDone.wait(lock, [this]
+                 { return !batchActive; });
+  batchActive = true;
+  batchJob = job;
+  batchContext = context;
+  batchJobCount = jobCount;
+  workersBusy = workerCount;
+  ++batchGeneration;
+  batchStart.notify_all();
+
+  batchDone.wait(lock, [this]
+                 { return workersBusy == 0; });
+  batchActive = false;
+  lock.unlock();
+  batchDone.notify_all();
+}
+
+void FfbWorkerPool::ParallelFor(void *pool, void (*job)(void *, uint32_t), void *context, uint32_t jobCount)
+{
+  ((FfbWorkerPool *)pool)->Run(job, context, jobCount);
+}
+
+void FfbWorkerPool::WorkerLoop(uint16_t workerIdx)
+{
+  currentPool = this;
+  uint64_t seenGeneration = 0;
+  for (;;)
+  {
+    void (*job)(void *, uint32_t);
+    void *context;
+    uint32_t jobCount;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      batchStart.wait(lock, [&]
+                      { return stopping || batchGeneration != seenGeneration; });
+      if (stopping)
+        return;
+
+      seenGeneration = batchGeneration;
+      job = batchJob;
+      context = batchContext;
+      jobCount = batchJobCount;
+    }
+
+    for (uint32_t jobIdx = workerIdx; jobIdx < jobCount; jobIdx += workerCount)
+      job(context, jobIdx);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--workersBusy == 0)
+        batchDone.notify_all();
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+  Force Feedback Joystick
+  Fixed worker thread pool for host side simulations.
+  Copyright 2025  Jaka Simonic    (telesimke [at] gmail [dot] com)
+  MIT License.
+  Permission to use, copy, modify, distribute, and sell this
+  software and its documentation for any purpose is hereby granted
+  without fee, provided that the above copyright notice appear in
+  all copies and that both that the copyright notice and this
+  permission notice and warranty disclaimer appear in supporting
+  documentation, and that the name of the author not be used in
+  advertising or publicity pertaining to distribution of the
+  software without specific, written prior permission.
+  The author disclaim all warranties with regard to this
+  software, including all implied warranties of merchantability
+  and fitness.  In no event shall the author be liable for any
+  special, indirect or consequential damages or any damages
+  whatsoever resulting from loss of use, data or profits, whether
+  in an action of contract, negligence or other tortious action,
+  arising out of or in connection with the use or performance of
+  this software.
+*/
+#ifndef FFBWORKERPOOL_h
+#define FFBWORKERPOOL_h
+
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+// Runs batches of jobs on a fixed set of threads. Job i always runs on worker i % GetWorkerCount(),
+// so state touched by a job stays on the same thread (and core, when pinned) from batch to batch.
+class FfbWorkerPool
+{
+public:
+  FfbWorkerPool(uint16_t workerCount, bool pinToCores = false);
+  ~FfbWorkerPool();
+
+  // Calls job(context, i) for every i < jobCount and returns when all of them finished.
+  // Only one batch runs at a time, Run from other threads waits for it. A Run from inside a job of
+  // the same pool runs its jobs inline.
+  void Run(void (*job)(void *context, uint32_t jobIdx), void *context, uint32_t jobCount);
+  uint16_t GetWorkerCount() const;
+  // Adapter for FfbEngine::SetParallelEvaluation, runner is the pool
+  static void ParallelFor(void *pool, void (*job)(void *context, uint32_t jobIdx), void *context, uint32_t jobCount);
+
+private:
+  void WorkerLoop(uint16_t workerIdx);
+
+  // pool whose job the calling thread is running, nullptr outside of workers
+  static thread_local const FfbWorkerPool *currentPool;
+
+  uint16_t workerCount;
+  std::unique_ptr<std::thread[]> workers;
+
+  std::mutex mutex;
+  std::condition_variable batchStart;
+  std::condition_variable batchDone;
+  uint64_t batchGeneration = 0;
+  uint16_t workersBusy = 0;
+  bool batchActive = false;
+  bool stopping = false;
+
+  void (*batchJob)(void *, uint32_t) = nullptr;
+  void *batchContext = nullptr;
+  uint32_t batchJobCount = 0;
+};
+
+#endif
@@ -33,12 +33,19 @@
     This mirrors the layout described to the host in the HID report descriptor, in Descriptors.c.
 */
 
-// Maximum number of parallel effects in memory
+// Maximum number of parallel effects in memory, can be overridden at build time (CMake FFB_MAX_EFFECTS).
+// Effect block indices are 8 bit and 0xFF addresses all effects, so at most 254 effects are possible.
+#ifndef MAX_EFFECTS
 #define MAX_EFFECTS 40
+#endif
+static_assert(MAX_EFFECTS >= 1 && MAX_EFFECTS <= 254, "MAX_EFFECTS must be between 1 and 254");
 #define SIZE_EFFECT sizeof(TEffectState)
 #define MEMORY_SIZE (uint16_t)(MAX_EFFECTS * SIZE_EFFECT)
 #define TO_LT_END_16(x) ((x << 8) & 0xFF00) | ((x >> 8) & 0x00FF)
 
+// Report structs mirror the wire layout of FfbWheelDescriptor.h, without padding on any ABI
+#pragma pack(push, 1)
+
 // ---- Input
 typedef struct
 { // WheelReport
@@ -81,8 +88,8 @@ typedef struct
   uint8_t effectBlockIndex; // 1..40
   uint16_t attackLevel;     // 0..255
   uint16_t fadeLevel;       // 0..255
-  uint16_t attackTime;      // 4294967295 ms
-  uint16_t fadeTime;        // 4294967295 ms
+  uint16_t attackTime;      // 0..32767 ms
+  uint16_t fadeTime;        // 0..32767 ms
 } USB_FFBReport_SetEnvelope_Output_Data_t;
 
 typedef struct
@@ -172,6 +179,102 @@ typedef struct
   uint16_t samplePeriod; // 0..32767 ms
 } USB_FFBReport_SetCustomForce_Output_Data_t;
 
+typedef struct
+{                           // FFB: Timed Effect Operation Output Report (vendor defined)
+  uint8_t reportId;         // =15
+  uint8_t effectBlockIndex; // 1..40
+  uint8_t operation;        // 1=Start, 2=StartSolo, 3=Stop
+  uint8_t loopCount;
+  uint32_t applyTime; // low 32 bits of the device time in ms
+} USB_FFBReport_TimedEffectOperation_Output_Data_t;
+
+typedef struct
+{
+  uint8_t effectBlockIndex; // 1..40
+  uint8_t parameter;        // 1=Magnitude, 2=Offset
+  int16_t value;            // -255..255
+} USB_FFBReport_BulkUpdateEntry_t;
+
+// Parameter updates one bulk update report carries
+#ifndef FFB_BULK_UPDATE_ENTRIES
+#define FFB_BULK_UPDATE_ENTRIES 15
+#endif
+
+typedef struct
+{                     // FFB: Bulk Update Output Report (vendor defined)
+  uint8_t reportId;   // =16
+  uint8_t entryCount; // 0..FFB_BULK_UPDATE_ENTRIES
+  USB_FFBReport_BulkUpdateEntry_t entries[FFB_BULK_UPDATE_ENTRIES];
+} USB_FFBReport_BulkUpdate_Output_Data_t;
+
+typedef struct
+{
+  uint16_t time;            // ms from the timeline start, steps are in time order
+  uint8_t effectBlockIndex; // 1..40
+  uint8_t action;           // 1=Start, 2=StartSolo, 3=Stop, 4=Set Magnitude, 5=Set Offset
+  int16_t value;            // -255..255 for Set Magnitude and Set Offset
+} USB_FFBReport_TimelineStep_t;
+
+// Timeline steps one set timeline report carries
+#ifndef FFB_TIMELINE_STEPS_PER_REPORT
+#define FFB_TIMELINE_STEPS_PER_REPORT 8
+#endif
+
+typedef struct
+{                        // FFB: Set Timeline Output Report (vendor defined)
+  uint8_t reportId;      // =17
+  uint8_t timelineIndex; // 1..FFB_MAX_TIMELINES
+  uint8_t stepOffset;    // first step the report writes
+  uint8_t stepCount;     // steps in the whole timeline
+  uint16_t loopPeriod;   // 0=play once, otherwise restarts every loopPeriod ms
+  USB_FFBReport_TimelineStep_t steps[FFB_TIMELINE_STEPS_PER_REPORT];
+} USB_FFBReport_SetTimeline_Output_Data_t;
+
+typedef struct
+{                        // FFB: Timeline Operation Output Report (vendor defined)
+  uint8_t reportId;      // =18
+  uint8_t timelineIndex; // 1..FFB_MAX_TIMELINES
+  uint8_t operation;     // 1=Start, 2=Stop
+} USB_FFBReport_TimelineOperation_Output_Data_t;
+
+typedef struct
+{                           // FFB: Set Modulation Output Report (vendor defined)
+  uint8_t reportId;         // =19
+  uint8_t modulationIndex;  // 1..FFB_MAX_MODULATIONS
+  uint8_t sourceBlockIndex; // 1..40, usually a periodic or ramp effect
+  uint8_t targetBlockIndex; // 1..40
+  int16_t depth;            // change at full source output, magnitude units or ms for the period
+  uint8_t destination;      // 0=Off, 1=Magnitude, 2=Offset, 3=Period
+} USB_FFBReport_SetModulation_Output_Data_t;
+
+// Wavetable points one set wavetable data report carries
+#ifndef FFB_WAVETABLE_POINTS_PER_REPORT
+#define FFB_WAVETABLE_POINTS_PER_REPORT 28
+#endif
+
+typedef struct
+{                           // FFB: Set Wavetable Data Output Report (vendor defined)
+  uint8_t reportId;         // =20
+  uint8_t effectBlockIndex; // 1..40
+  uint16_t pointCount;      // points in one period of the whole table
+  uint16_t dataOffset;      // first point the report writes
+  int16_t points[FFB_WAVETABLE_POINTS_PER_REPORT]; // -32767..32767, full scale is the periodic magnitude
+} USB_FFBReport_SetWavetableData_Output_Data_t;
+
+// Points of one condition response curve
+#ifndef FFB_RESPONSE_CURVE_MAX_POINTS
+#define FFB_RESPONSE_CURVE_MAX_POINTS 16
+#endif
+
+typedef struct
+{                               // FFB: Set Response Curve Output Report (vendor defined)
+  uint8_t reportId;             // =21
+  uint8_t effectBlockIndex;     // 1..40
+  uint8_t parameterBlockOffset; // condition block the curve shapes, as in Set Condition
+  uint8_t pointCount;           // 2..FFB_RESPONSE_CURVE_MAX_POINTS, 0 removes the curve
+  int16_t points[FFB_RESPONSE_CURVE_MAX_POINTS]; // 0..32767, response over the metric range beyond the dead band
+} USB_FFBReport_SetResponseCurve_Output_Data_t;
+
 // ---- Features
 
 typedef struct
@@ -197,6 +300,34 @@ typedef struct
   uint16_t ramPoolAvailable; // =0 or 0xFFFF?
 } USB_FFBReport_PIDBlockLoad_Feature_Data_t;
 
+#pragma pack(pop)
+
+// report lengths including the report ID, as declared in FfbWheelDescriptor.h
+static_assert(sizeof(USB_FFBReport_PIDStatus_Input_Data_t) == 3, "PID State report length");
+static_assert(sizeof(USB_FFBReport_SetEffect_Output_Data_t) == 18, "Set Effect report length");
+static_assert(sizeof(USB_FFBReport_SetEnvelope_Output_Data_t) == 10, "Set Envelope report length");
+static_assert(sizeof(USB_FFBReport_SetCondition_Output_Data_t) == 15, "Set Condition report length");
+static_assert(sizeof(USB_FFBReport_SetPeriodic_Output_Data_t) == 10, "Set Periodic report length");
+static_assert(sizeof(USB_FFBReport_SetConstantForce_Output_Data_t) == 4, "Set Constant Force report length");
+static_assert(sizeof(USB_FFBReport_SetRampForce_Output_Data_t) == 6, "Set Ramp Force report length");
+static_assert(sizeof(USB_FFBReport_SetCustomForceData_Output_Data_t) == 16, "Custom Force Data report length");
+static_assert(sizeof(USB_FFBReport_SetDownloadForceSample_Output_Data_t) == 3, "Download Force Sample report length");
+static_assert(sizeof(USB_FFBReport_EffectOperation_Output_Data_t) == 4, "Effect Operation report length");
+static_assert(sizeof(USB_FFBReport_BlockFree_Output_Data_t) == 2, "Block Free report length");
+static_assert(sizeof(USB_FFBReport_DeviceControl_Output_Data_t) == 2, "Device Control report length");
+static_assert(sizeof(USB_FFBReport_DeviceGain_Output_Data_t) == 2, "Device Gain report length");
+static_assert(sizeof(USB_FFBReport_SetCustomForce_Output_Data_t) == 5, "Set Custom Force report length");
+static_assert(sizeof(USB_FFBReport_TimedEffectOperation_Output_Data_t) == 8, "Timed Effect Operation report length");
+static_assert(sizeof(USB_FFBReport_BulkUpdate_Output_Data_t) == 2 + 4 * FFB_BULK_UPDATE_ENTRIES, "Bulk Update report length");
+static_assert(sizeof(USB_FFBReport_SetTimeline_Output_Data_t) == 6 + 6 * FFB_TIMELINE_STEPS_PER_REPORT, "Set Timeline report length");
+static_assert(sizeof(USB_FFBReport_TimelineOperation_Output_Data_t) == 3, "Timeline Operation report length");
+static_assert(sizeof(USB_FFBReport_SetModulation_Output_Data_t) == 7, "Set Modulation report length");
+static_assert(sizeof(USB_FFBReport_SetWavetableData_Output_Data_t) == 6 + 2 * FFB_WAVETABLE_POINTS_PER_REPORT, "Set Wavetable Data report length");
+static_assert(sizeof(USB_FFBReport_SetResponseCurve_Output_Data_t) == 4 + 2 * FFB_RESPONSE_CURVE_MAX_POINTS, "Set Response Curve report length");
+static_assert(sizeof(USB_FFBReport_CreateNewEffect_Feature_Data_t) == 4, "Create New Effect report length");
+static_assert(sizeof(USB_FFBReport_PIDBlockLoad_Feature_Data_t) == 5, "PID Block Load report length");
+static_assert(sizeof(USB_FFBReport_PIDPool_Feature_Data_t) == 5, "PID Pool report length");
+
 // ---- effect
 
 #define USB_DURATION_INFINITE 0x7FFF
@@ -220,6 +351,7 @@ typedef struct
 #define USB_EFFECT_INERTIA 0x0A
 #define USB_EFFECT_FRICTION 0x0B
 #define USB_EFFECT_CUSTOM 0x0C
+#define USB_EFFECT_WAVETABLE 0x0D // vendor defined, periodic parameters with an uploaded wave
 
 // Bit-masks for effect states
 #define MEFFECTSTATE_FREE 0x00
@@ -239,10 +371,20 @@ typedef struct
 #define SET_PERIODIC_REPORT 4
 #define SET_CONSTANT_FORCE_REPORT 5
 #define SET_RAMP_FORCE_REPORT 6
+#define SET_CUSTOM_FORCE_DATA_REPORT 7
+#define SET_DOWNLOAD_FORCE_SAMPLE_REPORT 8
 #define SET_EFFECT_OPERATION_REPORT 10
 #define SET_BLOCK_FREE_REPORT 11
 #define SET_DEVICE_CONTROL_REPORT 12
 #define SET_DEVICE_GAIN_REPORT 13
+#define SET_CUSTOM_FORCE_REPORT 14
+#define SET_TIMED_EFFECT_OPERATION_REPORT 15
+#define SET_BULK_UPDATE_REPORT 16
+#define SET_TIMELINE_REPORT 17
+#define SET_TIMELINE_OPERATION_REPORT 18
+#define SET_MODULATION_REPORT 19
+#define SET_WAVETABLE_DATA_REPORT 20
+#define SET_RESPONSE_CURVE_REPORT 21
 typedef struct
 {
   union
@@ -267,4 +409,106 @@ typedef struct
   TEffectParameter parameters[NUM_AXES];
 } TEffectState;
 
+// Parameter updates that can wait for the next tick when report coalescing is enabled
+#ifndef FFB_MAX_PENDING_REPORTS
+#define FFB_MAX_PENDING_REPORTS 16
+#endif
+
+// Bulk update parameters
+#define BULK_UPDATE_MAGNITUDE 1
+#define BULK_UPDATE_OFFSET 2
+
+// Timeline step actions
+#define TIMELINE_START 1
+#define TIMELINE_START_SOLO 2
+#define TIMELINE_STOP 3
+#define TIMELINE_SET_MAGNITUDE 4
+#define TIMELINE_SET_OFFSET 5
+
+// Timelines the sequencer stores and steps each of them holds
+#ifndef FFB_MAX_TIMELINES
+#define FFB_MAX_TIMELINES 2
+#endif
+#ifndef FFB_TIMELINE_MAX_STEPS
+#define FFB_TIMELINE_MAX_STEPS 32
+#endif
+
+// Timed effect operations waiting for their apply time
+#ifndef FFB_MAX_TIMED_OPERATIONS
+#define FFB_MAX_TIMED_OPERATIONS 8
+#endif
+
+// Custom force effects that can hold samples at the same time, and samples each of them holds
+#ifndef FFB_MAX_CUSTOM_EFFECTS
+#define FFB_MAX_CUSTOM_EFFECTS 2
+#endif
+#ifndef FFB_CUSTOM_FORCE_MAX_SAMPLES
+#define FFB_CUSTOM_FORCE_MAX_SAMPLES 64
+#endif
+#define USB_MAX_CUSTOM_SAMPLE 127
+#define CUSTOM_FORCE_FREE 0xFF
+
+typedef struct
+{
+  uint8_t effectIdx;     // owning effect, CUSTOM_FORCE_FREE when unused
+  uint8_t sampleCount;   // samples in one cycle, from the Set Custom Force report
+  uint16_t samplePeriod; // ms, from the Set Custom Force report
+  uint16_t writtenCount; // samples written so far, used when no sampleCount was set
+  // sample ring, custom force data reports write at dataOffset modulo the size
+  int8_t samples[FFB_CUSTOM_FORCE_MAX_SAMPLES];
+} TCustomForce;
+
+// Wavetable effects that can hold a table at the same time, and points each table holds
+#ifndef FFB_MAX_WAVETABLES
+#define FFB_MAX_WAVETABLES 2
+#endif
+#ifndef FFB_WAVETABLE_MAX_POINTS
+#define FFB_WAVETABLE_MAX_POINTS 64
+#endif
+#define USB_MAX_WAVETABLE_POINT 32767
+#define WAVETABLE_FREE 0xFF
+
+typedef struct
+{
+  uint8_t effectIdx;   // owning effect, WAVETABLE_FREE when unused
+  uint16_t pointCount; // points in one period
+  int16_t points[FFB_WAVETABLE_MAX_POINTS];
+} TWavetable;
+
+// Condition blocks that can have a response curve at the same time
+#ifndef FFB_MAX_RESPONSE_CURVES
+#define FFB_MAX_RESPONSE_CURVES 4
+#endif
+#define USB_MAX_RESPONSE_CURVE_POINT 32767
+#define RESPONSE_CURVE_FREE 0xFF
+
+// Replaces the linear part of a condition: the points span 0..USB_AXIS_MAX_ABSOLUTE of metric beyond the dead band
+// and the coefficients scale them, so {0, 32767} is the plain linear condition. Saturation still applies.
+typedef struct
+{
+  uint8_t effectIdx; // owning effect, RESPONSE_CURVE_FREE when unused
+  uint8_t parameterBlockOffset;
+  uint8_t pointCount;
+  int16_t points[FFB_RESPONSE_CURVE_MAX_POINTS];
+} TResponseCurve;
+
+// Modulation routes, each adds the output of a source effect to a parameter of a target effect
+#ifndef FFB_MAX_MODULATIONS
+#define FFB_MAX_MODULATIONS 4
+#endif
+#define MODULATION_OFF 0
+#define MODULATION_MAGNITUDE 1
+#define MODULATION_OFFSET 2
+#define MODULATION_PERIOD 3
+
+typedef struct
+{
+  uint8_t sourceIdx;
+  uint8_t targetIdx;
+  uint8_t destination; // MODULATION_*
+  int16_t depth;
+} TModulation;
+
+static_assert((uint32_t)MAX_EFFECTS * SIZE_EFFECT <= 0xFFFF, "PID pool size does not fit the 16 bit RAM pool report");
+
 #endif
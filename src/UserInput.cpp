@@ -34,9 +34,9 @@ void UserInput::UpdatePosition(const int32_t newPosition[NUM_AXES])
     int32_t tempSpeed = newPosition[i] - metrics[position][i];
     int32_t tempAcc = tempSpeed - metrics[speed][i];
 
-    metrics[position][i] = newPosition[i];
-    metrics[speed][i] = tempSpeed;
-    metrics[acceleration][i] = tempAcc;
+    SetMetric(position, i, newPosition[i]);
+    SetMetric(speed, i, tempSpeed);
+    SetMetric(acceleration, i, tempAcc);
   }
 }
 
@@ -44,23 +44,49 @@ void UserInput::UpdateMetrics(const int32_t newPosition[NUM_AXES], const int32_t
 {
   for (uint8_t i = 0; i < NUM_AXES; ++i)
   {
-    metrics[position][i] = newPosition[i];
-    metrics[speed][i] = newSpeed[i];
-    metrics[acceleration][i] = newAcc[i];
+    SetMetric(position, i, newPosition[i]);
+    SetMetric(speed, i, newSpeed[i]);
+    SetMetric(acceleration, i, newAcc[i]);
   }
 }
 
+void UserInput::SetMetric(Metric m, uint8_t axis, int32_t value)
+{
+  if (metrics[m][axis] == value)
+    return;
+
+  metrics[m][axis] = value;
+  ++revision;
+}
+
 void UserInput::UpdateButtons(int8_t buttons)
 {
-  buttonsState = buttons;
+  uint8_t newState = buttons;
+  buttonsPressed |= newState & ~buttonsState;
+  buttonsReleased |= ~newState & buttonsState;
+  buttonsState = newState;
 }
 
-const int32_t *UserInput::GetMetric(Metric m)
+const int32_t *UserInput::GetMetric(Metric m) const
 {
   return (const int32_t *)metrics[m];
 }
 
-uint8_t UserInput::GetButtons()
+uint32_t UserInput::GetRevision() const
+{
+  return revision;
+}
+
+uint8_t UserInput::GetButtons() const
 {
   return buttonsState;
 }
+
+bool UserInput::ConsumeButtonEdges(uint8_t &pressed, uint8_t &released)
+{
+  pressed = buttonsPressed;
+  released = buttonsReleased;
+  buttonsPressed = 0;
+  buttonsReleased = 0;
+  return (pressed | released) != 0;
+}
@@ -33,7 +33,9 @@ public:
     void UpdatePosition(const int32_t[NUM_AXES]);
     void UpdateMetrics(const int32_t[NUM_AXES], const int32_t[NUM_AXES], const int32_t[NUM_AXES]);
     void UpdateButtons(int8_t);
-    uint8_t GetButtons();
+    uint8_t GetButtons() const;
+    // Returns true and clears the edges when any button changed since the previous call
+    bool ConsumeButtonEdges(uint8_t &pressed, uint8_t &released);
 
     enum Metric
     {
@@ -42,11 +44,18 @@ public:
         acceleration,
         metricsCount
     };
-    const int32_t *GetMetric(Metric);
+    const int32_t *GetMetric(Metric) const;
+    // Changes whenever any metric value changes
+    uint32_t GetRevision() const;
 
 private:
+    void SetMetric(Metric, uint8_t axis, int32_t value);
+
     int32_t metrics[metricsCount][NUM_AXES] = {0};
+    uint32_t revision = 0;
     uint8_t buttonsState = 0;
+    uint8_t buttonsPressed = 0;
+    uint8_t buttonsReleased = 0;
 };
 
 #endif
\ No newline at end of file
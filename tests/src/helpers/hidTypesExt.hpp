@@ -1,5 +1,7 @@
 #ifndef HID_TYPES_EXT
 #define HID_TYPES_EXT
+#include <string.h>
+#include <initializer_list>
 #include "HIDReportType.h"
 
 struct DeviceGain_Ext : public USB_FFBReport_DeviceGain_Output_Data_t
@@ -146,4 +148,123 @@ struct EffectOperation_Ext : public USB_FFBReport_EffectOperation_Output_Data_t
     }
 };
 
+struct SetCustomForce_Ext : public USB_FFBReport_SetCustomForce_Output_Data_t
+{
+    SetCustomForce_Ext(uint8_t effectBlockIndex, uint8_t sampleCount, uint16_t samplePeriod)
+    {
+        this->reportId = SET_CUSTOM_FORCE_REPORT;
+        this->effectBlockIndex = effectBlockIndex;
+        this->sampleCount = sampleCount;
+        this->samplePeriod = samplePeriod;
+    }
+};
+
+struct SetCustomForceData_Ext : public USB_FFBReport_SetCustomForceData_Output_Data_t
+{
+    SetCustomForceData_Ext(uint8_t effectBlockIndex, uint16_t dataOffset, std::initializer_list<int8_t> samples)
+    {
+        this->reportId = SET_CUSTOM_FORCE_DATA_REPORT;
+        this->effectBlockIndex = effectBlockIndex;
+        this->dataOffset = dataOffset;
+        memset(this->data, 0, sizeof(this->data));
+        memcpy(this->data, samples.begin(), samples.size() < sizeof(this->data) ? samples.size() : sizeof(this->data));
+    }
+};
+
+struct SetDownloadForceSample_Ext : public USB_FFBReport_SetDownloadForceSample_Output_Data_t
+{
+    SetDownloadForceSample_Ext(int8_t x, int8_t y)
+    {
+        this->reportId = SET_DOWNLOAD_FORCE_SAMPLE_REPORT;
+        this->x = x;
+        this->y = y;
+    }
+};
+
+struct TimedEffectOperation_Ext : public USB_FFBReport_TimedEffectOperation_Output_Data_t
+{
+    TimedEffectOperation_Ext(uint8_t effectBlockIndex, uint8_t operation, uint32_t applyTime, uint8_t loopCount = 0)
+    {
+        this->reportId = SET_TIMED_EFFECT_OPERATION_REPORT;
+        this->effectBlockIndex = effectBlockIndex;
+        this->operation = operation;
+        this->loopCount = loopCount;
+        this->applyTime = applyTime;
+    }
+};
+
+struct BulkUpdate_Ext : public USB_FFBReport_BulkUpdate_Output_Data_t
+{
+    BulkUpdate_Ext(std::initializer_list<USB_FFBReport_BulkUpdateEntry_t> entries)
+    {
+        this->reportId = SET_BULK_UPDATE_REPORT;
+        this->entryCount = entries.size() < FFB_BULK_UPDATE_ENTRIES ? entries.size() : FFB_BULK_UPDATE_ENTRIES;
+        memset(this->entries, 0, sizeof(this->entries));
+        memcpy(this->entries, entries.begin(), this->entryCount * sizeof(USB_FFBReport_BulkUpdateEntry_t));
+    }
+};
+
+struct SetTimeline_Ext : public USB_FFBReport_SetTimeline_Output_Data_t
+{
+    SetTimeline_Ext(uint8_t timelineIndex, uint8_t stepOffset, uint8_t stepCount, uint16_t loopPeriod, std::initializer_list<USB_FFBReport_TimelineStep_t> steps)
+    {
+        this->reportId = SET_TIMELINE_REPORT;
+        this->timelineIndex = timelineIndex;
+        this->stepOffset = stepOffset;
+        this->stepCount = stepCount;
+        this->loopPeriod = loopPeriod;
+        memset(this->steps, 0, sizeof(this->steps));
+        memcpy(this->steps, steps.begin(), (steps.size() < FFB_TIMELINE_STEPS_PER_REPORT ? steps.size() : FFB_TIMELINE_STEPS_PER_REPORT) * sizeof(USB_FFBReport_TimelineStep_t));
+    }
+};
+
+struct TimelineOperation_Ext : public USB_FFBReport_TimelineOperation_Output_Data_t
+{
+    TimelineOperation_Ext(uint8_t timelineIndex, uint8_t operation)
+    {
+        this->reportId = SET_TIMELINE_OPERATION_REPORT;
+        this->timelineIndex = timelineIndex;
+        this->operation = operation;
+    }
+};
+
+struct SetModulation_Ext : public USB_FFBReport_SetModulation_Output_Data_t
+{
+    SetModulation_Ext(uint8_t modulationIndex, uint8_t sourceBlockIndex, uint8_t targetBlockIndex, uint8_t destination, int16_t depth)
+    {
+        this->reportId = SET_MODULATION_REPORT;
+        this->modulationIndex = modulationIndex;
+        this->sourceBlockIndex = sourceBlockIndex;
+        this->targetBlockIndex = targetBlockIndex;
+        this->destination = destination;
+        this->depth = depth;
+    }
+};
+
+struct SetWavetableData_Ext : public USB_FFBReport_SetWavetableData_Output_Data_t
+{
+    SetWavetableData_Ext(uint8_t effectBlockIndex, uint16_t pointCount, uint16_t dataOffset, const int16_t *points, uint8_t count)
+    {
+        memset(this, 0, sizeof(*this));
+        this->reportId = SET_WAVETABLE_DATA_REPORT;
+        this->effectBlockIndex = effectBlockIndex;
+        this->pointCount = pointCount;
+        this->dataOffset = dataOffset;
+        memcpy(this->points, points, count * sizeof(int16_t));
+    }
+};
+
+struct SetResponseCurve_Ext : public USB_FFBReport_SetResponseCurve_Output_Data_t
+{
+    SetResponseCurve_Ext(uint8_t effectBlockIndex, uint8_t parameterBlockOffset, const int16_t *points, uint8_t pointCount)
+    {
+        memset(this, 0, sizeof(*this));
+        this->reportId = SET_RESPONSE_CURVE_REPORT;
+        this->effectBlockIndex = effectBlockIndex;
+        this->parameterBlockOffset = parameterBlockOffset;
+        this->pointCount = pointCount;
+        memcpy(this->points, points, pointCount * sizeof(int16_t));
+    }
+};
+
 #endif // HID_TYPES_EXT
\ No newline at end of file
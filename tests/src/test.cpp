@@ -8,6 +8,8 @@
 #include "UserInput.h"
 #include "FfbEngine.h"
 #include "FfbReportHandler.h"
+#include "FfbDirection.h"
+#include "FfbOutputInterpolator.h"
 #include "HIDReportType.h"
 #include "helpers/hidTypesExt.hpp"
 
@@ -269,6 +271,45 @@ TEST_F(HidAbstractor, TestPaused)
     EXPECT_EQ(forces[0], 0);
 }
 
+TEST_F(HidAbstractor, TestPausedDelay)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        1,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        2);
+
+    SetReport<SetConstantForce_Ext>(effectBlock, 100);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    int forces[2] = {0};
+
+    TickFakeTime();
+    SetReport<DeviceControl_Ext>(5);
+    SetReport<DeviceControl_Ext>(5);
+
+    TickFakeTime(10);
+    SetReport<DeviceControl_Ext>(6);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+
+    TickFakeTime();
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    TickFakeTime();
+    SetReport<DeviceControl_Ext>(6);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+}
+
 TEST_P(HidAbstractorParametrized, TestAllConditionEffects)
 {
     int conditionType = GetParam();
@@ -339,6 +380,51 @@ TEST_F(HidAbstractor, TestConstantTriggerButton)
     EXPECT_EQ(forces[0], 0);
 }
 
+TEST_F(HidAbstractor, TestTriggerButtonHeldBeforeStart)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        2,
+        3,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        2,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetReport<SetConstantForce_Ext>(effectBlock, 100);
+    int forces[2] = {0};
+
+    ui.UpdateButtons(2);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    SetFakeTime(2);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+
+    SetFakeTime(1000);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+    EXPECT_EQ(ffh->GetNextDeadline(), 1002);
+
+    ui.UpdateButtons(0);
+    ui.UpdateButtons(2);
+    ui.UpdateButtons(0);
+    TickFakeTime();
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+}
+
 TEST_F(HidAbstractor, TestConditionDirectionOffset)
 {
     int effectBlock = CreateEffect(
@@ -784,3 +870,1142 @@ TEST_F(HidAbstractor, TestConstantYSolo)
     EXPECT_EQ(forces[0], 0);
     EXPECT_EQ(forces[1], 0);
 }
+
+TEST(ExplicitTime, TestLockstep)
+{
+    UserInput ui;
+    FfbReportHandler ffh;
+    FfbEngine ffe(ffh, ui);
+
+    USB_FFBReport_CreateNewEffect_Feature_Data_t createEffect = {};
+    ffh.FfbOnCreateNewEffect(&createEffect);
+    int effectBlock = ffh.FfbOnPIDBlockLoad()[1];
+
+    SetEffect_Ext effect(effectBlock, USB_EFFECT_RAMP, 4, ZERO_TRIGGER_REPEAT_INTERVAL, ZERO_SAMPLE_INTERVAL, USB_MAX_GAIN, USB_NO_TRIGGER_BUTTON, X_AXIS_ENABLE, 0, 0, ZERO_START_DELAY);
+    SetRampForce_Ext ramp(effectBlock, 60, 100);
+    EffectOperation_Ext start(effectBlock, 1);
+    ffh.FfbOnUsbData((uint8_t *)&effect, sizeof(effect), 1000);
+    ffh.FfbOnUsbData((uint8_t *)&ramp, sizeof(ramp), 1000);
+    ffh.FfbOnUsbData((uint8_t *)&start, sizeof(start), 1000);
+
+    int forces[2] = {0};
+    ffe.ForceCalculator(1000, forces);
+    EXPECT_EQ(forces[0], 60);
+
+    ffe.ForceCalculator(1002, forces);
+    EXPECT_EQ(forces[0], 80);
+
+    // without a clock callback the overloads without time reuse the last explicit time
+    ffe.ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 80);
+
+    DeviceControl_Ext pause(5);
+    DeviceControl_Ext resume(6);
+    ffh.FfbOnUsbData((uint8_t *)&pause, sizeof(pause), 1002);
+    ffh.FfbOnUsbData((uint8_t *)&resume, sizeof(resume), 2002);
+
+    ffe.ForceCalculator(2003, forces);
+    EXPECT_EQ(forces[0], 90);
+
+    ffe.ForceCalculator(2004, forces);
+    EXPECT_EQ(forces[0], 0);
+}
+
+TEST_F(HidAbstractor, TestNextDeadline)
+{
+    ResetFakeTime();
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        10,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        5000);
+
+    SetReport<SetConstantForce_Ext>(effectBlock, 100);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    int forces[2] = {0};
+
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+    EXPECT_EQ(ffh->GetNextDeadline(), 5000);
+
+    SetFakeTime(5000);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+    EXPECT_EQ(ffh->GetNextDeadline(), 5010);
+
+    SetReport<SetEffect_Ext>(effectBlock, USB_EFFECT_CONSTANT, 20, ZERO_TRIGGER_REPEAT_INTERVAL, ZERO_SAMPLE_INTERVAL, USB_MAX_GAIN, USB_NO_TRIGGER_BUTTON, X_AXIS_ENABLE, 0, 0, 5000);
+    SetFakeTime(5019);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    SetFakeTime(5020);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+}
+
+TEST_F(HidAbstractor, TestAdvanceEvaluate)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_RAMP,
+        4,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        1,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetReport<SetRampForce_Ext>(effectBlock, 60, 100);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    int forces[2] = {0};
+
+    ui.UpdateButtons(1);
+    ffe->Evaluate(0, forces);
+    EXPECT_EQ(forces[0], 0);
+
+    ffe->Advance(0);
+    ffe->Evaluate(2, forces);
+    EXPECT_EQ(forces[0], 80);
+
+    ffe->Evaluate(0, forces);
+    EXPECT_EQ(forces[0], 60);
+
+    ui.UpdateButtons(0);
+    ffe->Evaluate(1, forces);
+    EXPECT_EQ(forces[0], 70);
+
+    ffe->Advance(1);
+    ffe->Evaluate(1, forces);
+    EXPECT_EQ(forces[0], 0);
+}
+
+TEST_F(HidAbstractor, TestCachedForceInvalidation)
+{
+    ResetFakeTime();
+    int forces[2] = {0};
+
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+
+    int constantBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetReport<SetConstantForce_Ext>(constantBlock, 100);
+    SetReport<EffectOperation_Ext>(constantBlock, 1);
+
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    TickFakeTime(1000);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    SetReport<SetConstantForce_Ext>(constantBlock, 50);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 50);
+
+    int springBlock = CreateEffect(
+        USB_EFFECT_SPRING,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetReport<SetCondition_Ext>(springBlock, 0, 0, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, 0);
+    SetReport<EffectOperation_Ext>(springBlock, 1);
+
+    UpdatePosition({0, 0});
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 50);
+
+    int expected[2] = {0};
+    UpdatePosition({USB_AXIS_MAX_ABSOLUTE, 0});
+    ffe->ForceCalculator(forces);
+    ffe->Evaluate(GetFakeTime(), expected);
+    EXPECT_LT(forces[0], 0);
+    EXPECT_EQ(forces[0], expected[0]);
+
+    SetReport<DeviceGain_Ext>(128);
+    ffe->ForceCalculator(forces);
+    ffe->Evaluate(GetFakeTime(), expected);
+    EXPECT_EQ(forces[0], expected[0]);
+
+    SetReport<EffectOperation_Ext>(springBlock, 3);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 25);
+}
+
+TEST_F(HidAbstractor, TestStackedConditions)
+{
+    ResetFakeTime();
+
+    int effectBlocks[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        effectBlocks[i] = CreateEffect(
+            USB_EFFECT_SPRING,
+            USB_DURATION_INFINITE,
+            ZERO_TRIGGER_REPEAT_INTERVAL,
+            ZERO_SAMPLE_INTERVAL,
+            USB_MAX_GAIN / (i + 1),
+            USB_NO_TRIGGER_BUTTON,
+            X_AXIS_ENABLE,
+            0,
+            0,
+            ZERO_START_DELAY);
+        SetReport<EffectOperation_Ext>(effectBlocks[i], 1);
+    }
+    SetReport<SetCondition_Ext>(effectBlocks[0], 0, 0, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, 0);
+    SetReport<SetCondition_Ext>(effectBlocks[1], 0, USB_AXIS_MAX_ABSOLUTE / 4, USB_MAX_GAIN / 2, USB_MAX_GAIN, 100, 50, 1000);
+    SetReport<SetCondition_Ext>(effectBlocks[2], 0, -USB_AXIS_MAX_ABSOLUTE / 2, 30, 0, 20, USB_MAX_GAIN, 0);
+
+    const TEffectState *effectStates = ffh->GetEffectStates();
+    int forces[2] = {0};
+    for (int32_t position = -USB_AXIS_MAX_ABSOLUTE; position <= USB_AXIS_MAX_ABSOLUTE; position += 997)
+    {
+        UpdatePosition({position, 0});
+        ffe->ForceCalculator(forces);
+
+        float expected = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            const TEffectState &effect = effectStates[effectBlocks[i] - 1];
+            float conditionForce[2] = {0};
+            ffe->ConditionForceCalculator(effect, ui.GetMetric(UserInput::position), conditionForce);
+            expected += conditionForce[0] * effect.block.gain / USB_MAX_GAIN;
+        }
+        EXPECT_NEAR(forces[0], expected, 1);
+        EXPECT_EQ(forces[1], 0);
+    }
+}
+
+TEST_F(HidAbstractor, TestEffectValidUntil)
+{
+    ResetFakeTime();
+
+    int squareBlock = CreateEffect(
+        USB_EFFECT_SQUARE,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetPeriodic_Ext>(squareBlock, 40, 0, 0, 20);
+    SetReport<EffectOperation_Ext>(squareBlock, 1);
+
+    int constantBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        100,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(constantBlock, 100);
+    SetReport<SetEnvelope_Ext>(constantBlock, 0, 0, 10, 30);
+    SetReport<EffectOperation_Ext>(constantBlock, 1);
+
+    const TEffectState *effectStates = ffh->GetEffectStates();
+    const TEffectState &square = effectStates[squareBlock - 1];
+    const TEffectState &constant = effectStates[constantBlock - 1];
+    EXPECT_EQ(ffe->GetValidUntil(square, 0), 10);
+    EXPECT_EQ(ffe->GetValidUntil(square, 13), 20);
+    EXPECT_EQ(ffe->GetValidUntil(constant, 5), 6);
+    EXPECT_EQ(ffe->GetValidUntil(constant, 10), 70);
+    EXPECT_EQ(ffe->GetValidUntil(constant, 80), 81);
+
+    int forces[2] = {0};
+    int expected[2] = {0};
+    for (int time = 0; time < 120; ++time)
+    {
+        SetFakeTime(time);
+        ffe->ForceCalculator(forces);
+        ffe->Evaluate(time, expected);
+        EXPECT_EQ(forces[0], expected[0]);
+    }
+}
+
+TEST(Direction, TestSinCosTable)
+{
+    for (uint16_t angle = 0; angle <= USB_MAX_PHASE; ++angle)
+    {
+        float sinValue, cosValue;
+        FfbSinCos(angle, sinValue, cosValue);
+        EXPECT_NEAR(sinValue, sin(angle / (double)USB_NORMALIZE_RAD), 1e-6);
+        EXPECT_NEAR(cosValue, cos(angle / (double)USB_NORMALIZE_RAD), 1e-6);
+    }
+}
+
+TEST(Direction, TestPolarUnitVec)
+{
+    uint16_t angles[] = {(uint16_t)USB_RAD_45, USB_PI / 3};
+    float unitVec[3];
+    FfbDirectionToUnitVec(angles, 2, unitVec, 3);
+
+    double a0 = angles[0] / (double)USB_NORMALIZE_RAD, a1 = angles[1] / (double)USB_NORMALIZE_RAD;
+    EXPECT_NEAR(unitVec[0], cos(a0), 1e-6);
+    EXPECT_NEAR(unitVec[1], sin(a0) * cos(a1), 1e-6);
+    EXPECT_NEAR(unitVec[2], sin(a0) * sin(a1), 1e-6);
+    EXPECT_NEAR(unitVec[0] * unitVec[0] + unitVec[1] * unitVec[1] + unitVec[2] * unitVec[2], 1, 1e-6);
+
+    FfbDirectionToUnitVec(angles, 1, unitVec, 2);
+    EXPECT_NEAR(unitVec[0], cos(a0), 1e-6);
+    EXPECT_NEAR(unitVec[1], sin(a0), 1e-6);
+}
+
+TEST_F(HidAbstractor, TestDirectedForce)
+{
+    ResetFakeTime();
+
+    // each axis gets the force times its own component, cos(60 deg) and sin(30 deg)
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE | Y_AXIS_ENABLE,
+        USB_PI / 3,
+        USB_PI / 6,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(effectBlock, 200);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+
+    int forces[2] = {0};
+    ffe->ForceCalculator(forces);
+    EXPECT_NEAR(forces[0], 100, 1);
+    EXPECT_NEAR(forces[1], 100, 1);
+}
+
+TEST_F(HidAbstractor, TestForceAverage)
+{
+    ResetFakeTime();
+    int forces[2] = {0};
+
+    int sineBlock = CreateEffect(
+        USB_EFFECT_SINE,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetPeriodic_Ext>(sineBlock, 100, 0, 0, 10);
+    SetReport<EffectOperation_Ext>(sineBlock, 1);
+
+    ffe->ForceAverage(0, 10, forces);
+    EXPECT_EQ(forces[0], 0);
+    ffe->ForceAverage(0, 5, forces);
+    EXPECT_EQ(forces[0], (int)(200 / M_PI));
+    SetReport<EffectOperation_Ext>(sineBlock, 3);
+
+    int squareBlock = CreateEffect(
+        USB_EFFECT_SQUARE,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetPeriodic_Ext>(squareBlock, 100, 0, 0, 10);
+    SetReport<EffectOperation_Ext>(squareBlock, 1);
+
+    ffe->ForceAverage(0, 5, forces);
+    EXPECT_EQ(forces[0], 100);
+    ffe->ForceAverage(3, 8, forces);
+    EXPECT_EQ(forces[0], -20);
+    ffe->ForceAverage(0, 40, forces);
+    EXPECT_EQ(forces[0], 0);
+    SetReport<EffectOperation_Ext>(squareBlock, 3);
+
+    int rampBlock = CreateEffect(
+        USB_EFFECT_RAMP,
+        10,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetRampForce_Ext>(rampBlock, 0, 100);
+    SetReport<EffectOperation_Ext>(rampBlock, 1);
+
+    ffe->ForceAverage(0, 10, forces);
+    EXPECT_EQ(forces[0], 50);
+    // the ramp stops at 10
+    ffe->ForceAverage(0, 20, forces);
+    EXPECT_EQ(forces[0], 25);
+    SetReport<EffectOperation_Ext>(rampBlock, 3);
+
+    int constantBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(constantBlock, 100);
+    SetReport<SetEnvelope_Ext>(constantBlock, 0, 0, 10, 0);
+    SetReport<EffectOperation_Ext>(constantBlock, 1);
+
+    ffe->ForceAverage(0, 10, forces);
+    EXPECT_EQ(forces[0], 50);
+    ffe->ForceAverage(10, 20, forces);
+    EXPECT_EQ(forces[0], 100);
+}
+
+TEST(OutputInterpolator, TestLinear)
+{
+    FfbOutputInterpolator interpolator(4);
+    int32_t setpoint[2];
+
+    int32_t first[2] = {0, 100};
+    EXPECT_EQ(interpolator.Push(first), 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(interpolator.Pop(setpoint));
+        EXPECT_EQ(setpoint[0], 0);
+        EXPECT_EQ(setpoint[1], 100);
+    }
+
+    int32_t second[2] = {100, -100};
+    interpolator.Push(second);
+    EXPECT_EQ(interpolator.GetAvailable(), 4);
+    for (int i = 1; i <= 4; ++i)
+    {
+        EXPECT_TRUE(interpolator.Pop(setpoint));
+        EXPECT_EQ(setpoint[0], 25 * i);
+        EXPECT_EQ(setpoint[1], 100 - 50 * i);
+    }
+
+    EXPECT_FALSE(interpolator.Pop(setpoint));
+    EXPECT_EQ(setpoint[0], 100);
+    EXPECT_EQ(setpoint[1], -100);
+}
+
+TEST(OutputInterpolator, TestSmoothModes)
+{
+    int32_t zero[2] = {0, 0};
+    int32_t step[2] = {1000, 0};
+    int32_t setpoint[2];
+
+    FfbOutputInterpolator minimumJerk(4, FfbOutputInterpolator::minimumJerk);
+    minimumJerk.Push(zero);
+    for (int i = 0; i < 4; ++i)
+        minimumJerk.Pop(setpoint);
+    minimumJerk.Push(step);
+    minimumJerk.Pop(setpoint);
+    EXPECT_EQ(setpoint[0], (int32_t)(1000 * (10 - 15 * 0.25 + 6 * 0.0625) / 64));
+    minimumJerk.Pop(setpoint);
+    EXPECT_EQ(setpoint[0], 500);
+    minimumJerk.Pop(setpoint);
+    minimumJerk.Pop(setpoint);
+    EXPECT_EQ(setpoint[0], 1000);
+
+    FfbOutputInterpolator hermite(2, FfbOutputInterpolator::hermite);
+    hermite.Push(zero);
+    hermite.Push(zero);
+    for (int i = 0; i < 4; ++i)
+        hermite.Pop(setpoint);
+    hermite.Push(step);
+    hermite.Pop(setpoint);
+    EXPECT_GT(setpoint[0], 0);
+    EXPECT_LT(setpoint[0], 1000);
+    hermite.Pop(setpoint);
+    EXPECT_EQ(setpoint[0], 1000);
+}
+
+TEST(OutputInterpolator, TestStaleSetpoints)
+{
+    FfbOutputInterpolator interpolator(40);
+    int32_t force[2] = {0, 0};
+    int32_t setpoint[2];
+
+    // the consumer missed a whole tick, only the newest one is kept,
+    // the skipped setpoints are not overwritten before the consumer moved past them
+    EXPECT_EQ(interpolator.Push(force), 40);
+    force[0] = 400;
+    EXPECT_EQ(interpolator.Push(force), FFB_OUTPUT_RING_SIZE - 1 - 40);
+    EXPECT_EQ(interpolator.GetAvailable(), FFB_OUTPUT_RING_SIZE - 1 - 40);
+
+    for (int i = 1; i <= FFB_OUTPUT_RING_SIZE - 1 - 40; ++i)
+    {
+        EXPECT_TRUE(interpolator.Pop(setpoint));
+        EXPECT_NEAR(setpoint[0], i * 10, 1);
+    }
+    EXPECT_FALSE(interpolator.Pop(setpoint));
+
+    // less than a tick behind keeps the remaining setpoints
+    force[0] = 800;
+    interpolator.Push(force);
+    for (int i = 0; i < 30; ++i)
+        interpolator.Pop(setpoint);
+    force[0] = 1200;
+    EXPECT_EQ(interpolator.Push(force), 40);
+    EXPECT_EQ(interpolator.GetAvailable(), 50);
+    EXPECT_TRUE(interpolator.Pop(setpoint));
+    EXPECT_NEAR(setpoint[0], 710, 1);
+
+    // a ratio larger than the ring still writes the newest setpoints
+    FfbOutputInterpolator large(FFB_OUTPUT_RING_SIZE + 10);
+    EXPECT_EQ(large.Push(force), FFB_OUTPUT_RING_SIZE - 1);
+    EXPECT_EQ(large.Push(force), 0);
+    EXPECT_FALSE(large.Pop(setpoint));
+    EXPECT_EQ(large.Push(force), FFB_OUTPUT_RING_SIZE - 1);
+    EXPECT_EQ(large.GetAvailable(), FFB_OUTPUT_RING_SIZE - 1);
+}
+
+TEST_F(HidAbstractor, TestRenderPeriod)
+{
+    ResetFakeTime();
+    ffe->SetRenderPeriod(4);
+
+    int rampBlock = CreateEffect(
+        USB_EFFECT_RAMP,
+        100,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetRampForce_Ext>(rampBlock, 0, 100);
+    SetReport<EffectOperation_Ext>(rampBlock, 1);
+
+    int springBlock = CreateEffect(
+        USB_EFFECT_SPRING,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        Y_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetCondition_Ext>(springBlock, 1, 0, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, 0);
+    SetReport<EffectOperation_Ext>(springBlock, 1);
+
+    int forces[2] = {0};
+    int expected[2] = {0};
+    for (int time = 0; time < 12; ++time)
+    {
+        SetFakeTime(time);
+        UpdatePosition({0, time * 1000});
+        ffe->ForceCalculator(forces);
+
+        // the ramp is held for the render period, the spring follows every position
+        ffe->Evaluate(time - time % 4, expected);
+        EXPECT_EQ(forces[0], expected[0]);
+        ffe->Evaluate(time, expected);
+        EXPECT_EQ(forces[1], expected[1]);
+    }
+}
+
+TEST_F(HidAbstractor, TestCustomForce)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CUSTOM,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetReport<SetCustomForce_Ext>(effectBlock, 4, 2);
+    SetReport<SetCustomForceData_Ext>(effectBlock, 0, std::initializer_list<int8_t>{0, 127, -127, 0});
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+
+    int expected[] = {0, 127, 255, 0, -255, -127, 0, 0};
+    int forces[2] = {0};
+    for (int time = 0; time < 8; ++time)
+    {
+        SetFakeTime(time);
+        ffe->ForceCalculator(forces);
+        EXPECT_EQ(forces[0], expected[time]);
+    }
+
+    // averages integrate the line between the samples
+    ffe->ForceAverage(0, 8, forces);
+    EXPECT_NEAR(forces[0], 0, 1);
+    ffe->ForceAverage(0, 4, forces);
+    EXPECT_NEAR(forces[0], 64, 1);
+
+    // the ring wraps, later data reports overwrite the oldest samples
+    SetReport<SetCustomForceData_Ext>(effectBlock, FFB_CUSTOM_FORCE_MAX_SAMPLES, std::initializer_list<int8_t>{127});
+    SetFakeTime(8);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 255);
+
+    SetReport<BlockFree_Ext>(effectBlock);
+    EXPECT_EQ(ffh->GetCustomForce(effectBlock - 1), nullptr);
+}
+
+TEST_F(HidAbstractor, TestForceStream)
+{
+    ResetFakeTime();
+    ffh->SetStreamPlayout(2, 1, 4);
+
+    SetReport<SetDownloadForceSample_Ext>(127, -127);
+    SetFakeTime(1);
+    // a burst is spread out at the arrival interval
+    SetReport<SetDownloadForceSample_Ext>(64, 0);
+    SetReport<SetDownloadForceSample_Ext>(-64, 0);
+
+    // the last sample is held one ms past its successor's slot, then fades out over four
+    float expected[] = {0, 0, 255, 128.5f, -128.5f, -128.5f, -128.5f, -96.4f, -64.2f, -32.1f, 0, 0};
+    int forces[2] = {0};
+    for (int time = 0; time < 12; ++time)
+    {
+        SetFakeTime(time);
+        ffe->ForceCalculator(forces);
+        EXPECT_NEAR(forces[0], expected[time], 1);
+        EXPECT_EQ(forces[1], time == 2 ? -255 : 0);
+    }
+
+    // stopping all effects drops the stream
+    SetReport<SetDownloadForceSample_Ext>(127, 0);
+    SetReport<DeviceControl_Ext>(3);
+    SetFakeTime(20);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+}
+
+TEST_F(HidAbstractor, TestForceStreamDefaults)
+{
+    ResetFakeTime();
+    int forces[2] = {0};
+
+    // by default the last sample fades out when the host stops streaming
+    SetReport<SetDownloadForceSample_Ext>(127, 0);
+    const int times[] = {10, 21, 46, 71, 90};
+    const float expected[] = {255, 255, 127.5f, 0, 0};
+    for (int i = 0; i < 5; ++i)
+    {
+        SetFakeTime(times[i]);
+        ffe->ForceCalculator(forces);
+        EXPECT_NEAR(forces[0], expected[i], 1);
+    }
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(effectBlock, 0);
+
+    // the pause does not count as an arrival interval, samples play at the playout delay again
+    ffh->SetStreamPlayout(5, FFB_FORCE_STREAM_HOLD_TIME, FFB_FORCE_STREAM_DECAY_TIME);
+    SetFakeTime(100);
+    SetReport<SetDownloadForceSample_Ext>(50, 0);
+    SetFakeTime(101);
+    SetReport<SetDownloadForceSample_Ext>(100, 0);
+
+    // starting an effect solo stops the other effects, not the stream
+    SetReport<EffectOperation_Ext>(effectBlock, 2);
+    SetFakeTime(106);
+    ffe->ForceCalculator(forces);
+    EXPECT_NEAR(forces[0], 100 * 255 / 127.0f, 1);
+}
+
+TEST_F(HidAbstractor, TestBatchReports)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+
+    SetConstantForce_Ext constant(effectBlock, 100);
+    EffectOperation_Ext start(effectBlock, 1);
+    DeviceGain_Ext gain(128);
+
+    // reports are packed back to back, so most of them are unaligned
+    uint8_t batch[64];
+    uint16_t len = 0;
+    batch[len++] = 0;
+    memcpy(batch + len, &constant, sizeof(constant));
+    len += sizeof(constant);
+    memcpy(batch + len, &start, sizeof(start));
+    len += sizeof(start);
+    EXPECT_EQ(ffh->FfbOnUsbBatch(batch + 1, len - 1), 2);
+
+    int forces[2] = {0};
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+
+    // an unknown report ID ends the batch
+    len = 0;
+    batch[len++] = 9;
+    memcpy(batch + len, &gain, sizeof(gain));
+    len += sizeof(gain);
+    EXPECT_EQ(ffh->FfbOnUsbBatch(batch, len), 0);
+
+    // so does a truncated report
+    memcpy(batch, &gain, sizeof(gain));
+    memcpy(batch + sizeof(gain), &constant, sizeof(constant));
+    EXPECT_EQ(ffh->FfbOnUsbBatch(batch, sizeof(gain) + sizeof(constant) - 1), 1);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 50);
+
+    // single reports shorter than their type are dropped
+    SetConstantForce_Ext weaker(effectBlock, 10);
+    ffh->FfbOnUsbData((uint8_t *)&weaker, sizeof(weaker) - 1);
+    ffh->FfbOnUsbData((uint8_t *)&weaker, 0);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 50);
+
+    // reports have the lengths the descriptor declares, a 15 byte condition report and a 4 byte set constant force
+    const uint8_t wire[] = {SET_CONDITION_REPORT, (uint8_t)effectBlock, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                            SET_CONSTANT_FORCE_REPORT, (uint8_t)effectBlock, 200, 0};
+    EXPECT_EQ(ffh->FfbOnUsbBatch(wire, sizeof(wire)), 2);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+}
+
+TEST_F(HidAbstractor, TestCoalescedReports)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(effectBlock, 10);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+
+    int forces[2] = {0};
+    ffe->ForceCalculator(forces);
+
+    ffh->SetCoalescing(true);
+    uint32_t revision = ffh->GetRevision();
+    for (int16_t magnitude = 20; magnitude <= 100; magnitude += 20)
+    {
+        SetReport<SetConstantForce_Ext>(effectBlock, magnitude);
+    }
+    EXPECT_EQ(ffh->GetRevision(), revision);
+
+    // the newest copy is applied once at the tick
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+    EXPECT_EQ(ffh->GetRevision(), revision + 1);
+
+    // an operation report sees the updates sent before it
+    SetReport<SetConstantForce_Ext>(effectBlock, 50);
+    SetReport<EffectOperation_Ext>(effectBlock, 3);
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    EXPECT_EQ(ffh->GetEffectStates()[effectBlock - 1].parameters[0].constant.magnitude, 50);
+
+    // a full table is applied before it takes more updates
+    for (int block = 1; block <= FFB_MAX_PENDING_REPORTS + 1; ++block)
+    {
+        SetReport<SetConstantForce_Ext>(effectBlock, block);
+        SetReport<SetRampForce_Ext>(block, 0, 0);
+    }
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], FFB_MAX_PENDING_REPORTS + 1);
+
+    // feature reports keep the host order
+    SetReport<SetConstantForce_Ext>(effectBlock, 30);
+    USB_FFBReport_CreateNewEffect_Feature_Data_t createEffect = {};
+    ffh->FfbOnCreateNewEffect(&createEffect);
+    EXPECT_EQ(ffh->GetEffectStates()[effectBlock - 1].parameters[0].constant.magnitude, 30);
+
+    // a pool reset drops the reports queued for the freed effects
+    SetReport<SetConstantForce_Ext>(effectBlock, 40);
+    ffh->FfbOnPIDPool();
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(ffh->GetEffectStates()[effectBlock - 1].parameters[0].constant.magnitude, 0);
+}
+
+TEST_F(HidAbstractor, TestTimedEffectOperation)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(effectBlock, 100);
+
+    SetFakeTime(2);
+    // queued out of order, applied in time order
+    SetReport<TimedEffectOperation_Ext>(effectBlock, 3, 15);
+    SetReport<TimedEffectOperation_Ext>(effectBlock, 1, 10);
+    EXPECT_EQ(ffh->GetNextDeadline(), 10);
+
+    int expected[] = {0, 0, 0, 100, 100, 100, 100, 100, 0, 0};
+    int forces[2] = {0};
+    for (int step = 0; step < 10; ++step)
+    {
+        SetFakeTime(7 + step);
+        ffe->ForceCalculator(forces);
+        EXPECT_EQ(forces[0], expected[step]);
+    }
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+
+    // operations that are already late apply right away
+    SetReport<TimedEffectOperation_Ext>(effectBlock, 1, 3);
+    EXPECT_EQ(ffh->GetEffectStates()[effectBlock - 1].state & MEFFECTSTATE_PLAYING, MEFFECTSTATE_PLAYING);
+
+    // also shortly after boot, when the apply time lies before device time 0
+    SetReport<EffectOperation_Ext>(effectBlock, 3);
+    SetFakeTime(5);
+    SetReport<TimedEffectOperation_Ext>(effectBlock, 1, (uint32_t)(5 - 16));
+    EXPECT_EQ(ffh->GetEffectStates()[effectBlock - 1].state & MEFFECTSTATE_PLAYING, MEFFECTSTATE_PLAYING);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+
+    // freeing the effect drops its queued operations
+    SetReport<TimedEffectOperation_Ext>(effectBlock, 3, 30);
+    SetReport<BlockFree_Ext>(effectBlock);
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+}
+
+TEST_F(HidAbstractor, TestBulkUpdate)
+{
+    ResetFakeTime();
+
+    int constantBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(constantBlock, 10);
+    SetReport<EffectOperation_Ext>(constantBlock, 1);
+
+    int sineBlock = CreateEffect(
+        USB_EFFECT_SINE,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetPeriodic_Ext>(sineBlock, 100, 0, 0, 100);
+    SetReport<EffectOperation_Ext>(sineBlock, 1);
+
+    SetReport<BulkUpdate_Ext>(std::initializer_list<USB_FFBReport_BulkUpdateEntry_t>{
+        {(uint8_t)constantBlock, BULK_UPDATE_MAGNITUDE, 20},
+        {(uint8_t)sineBlock, BULK_UPDATE_MAGNITUDE, 0},
+        {(uint8_t)sineBlock, BULK_UPDATE_OFFSET, 30}});
+    // a second report in the same tick replaces the staged value
+    SetReport<BulkUpdate_Ext>(std::initializer_list<USB_FFBReport_BulkUpdateEntry_t>{
+        {(uint8_t)constantBlock, BULK_UPDATE_MAGNITUDE, 40}});
+
+    // other reports before the tick, a streamed sample included, leave the staged values alone
+    SetReport<SetDownloadForceSample_Ext>(0, 0);
+    SetReport<DeviceGain_Ext>(USB_MAX_GAIN);
+
+    const TEffectState *effects = ffh->GetEffectStates();
+    EXPECT_EQ(effects[constantBlock - 1].parameters[0].constant.magnitude, 10);
+
+    int forces[2] = {0};
+    ffe->ForceCalculator(forces);
+    // the sine is reduced to its offset
+    EXPECT_EQ(forces[0], 40 + 30);
+    EXPECT_EQ(effects[sineBlock - 1].parameters[0].periodic.magnitude, 0);
+}
+
+TEST_F(HidAbstractor, TestTimeline)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(effectBlock, 20);
+
+    uint8_t block = effectBlock;
+    SetReport<SetTimeline_Ext>(1, 0, 3, 8, std::initializer_list<USB_FFBReport_TimelineStep_t>{
+        {0, block, TIMELINE_START, 0},
+        {2, block, TIMELINE_SET_MAGNITUDE, 80},
+        {5, block, TIMELINE_STOP, 0}});
+
+    SetFakeTime(1);
+    SetReport<TimelineOperation_Ext>(1, 1);
+    EXPECT_EQ(ffh->GetNextDeadline(), 1);
+
+    // the timeline restarts every 8 ms
+    int expected[] = {20, 20, 80, 80, 80, 0, 0, 0, 80};
+    int forces[2] = {0};
+    for (int step = 0; step < 9; ++step)
+    {
+        SetFakeTime(1 + step);
+        ffe->ForceCalculator(forces);
+        EXPECT_EQ(forces[0], expected[step]);
+    }
+    EXPECT_EQ(ffh->GetNextDeadline(), 11);
+
+    // stopping the timeline leaves the effects as they are
+    SetReport<TimelineOperation_Ext>(1, 2);
+    EXPECT_EQ(ffh->GetNextDeadline(), FFB_TIME_NEVER);
+    SetFakeTime(20);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 80);
+}
+
+TEST_F(HidAbstractor, TestModulation)
+{
+    ResetFakeTime();
+
+    int targetBlock = CreateEffect(
+        USB_EFFECT_CONSTANT,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetConstantForce_Ext>(targetBlock, 100);
+
+    // a source without axes only modulates
+    int sourceBlock = CreateEffect(
+        USB_EFFECT_RAMP,
+        10,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        0,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetRampForce_Ext>(sourceBlock, (uint16_t)-USB_MAX_MAGNITUDE, USB_MAX_MAGNITUDE);
+
+    // the descriptor declares 7 bytes for the report
+    SetModulation_Ext route(1, sourceBlock, targetBlock, MODULATION_MAGNITUDE, 100);
+    ffh->FfbOnUsbData((uint8_t *)&route, 7);
+    SetReport<EffectOperation_Ext>(targetBlock, 1);
+    SetReport<EffectOperation_Ext>(sourceBlock, 1);
+
+    // averages hold the modulated magnitude for each millisecond, like the sampled force
+    int forces[2] = {0};
+    ffe->ForceAverage(0, 10, forces);
+    EXPECT_EQ(forces[0], 90);
+    ffe->ForceAverage(0, 5, forces);
+    EXPECT_EQ(forces[0], 40);
+
+    // the ramp sweeps the magnitude from 0 up, and leaves it alone once it ended
+    for (int time = 0; time < 12; ++time)
+    {
+        SetFakeTime(time);
+        ffe->ForceCalculator(forces);
+        EXPECT_EQ(forces[0], time < 10 ? 20 * time : 100);
+    }
+    EXPECT_EQ(ffh->GetEffectStates()[targetBlock - 1].parameters[0].constant.magnitude, 100);
+
+    SetReport<EffectOperation_Ext>(sourceBlock, 1);
+    SetReport<SetModulation_Ext>(1, sourceBlock, targetBlock, MODULATION_OFF, 100);
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 100);
+}
+
+TEST_F(HidAbstractor, TestWavetable)
+{
+    ResetFakeTime();
+
+    int effectBlock = CreateEffect(
+        USB_EFFECT_WAVETABLE,
+        USB_DURATION_INFINITE,
+        ZERO_TRIGGER_REPEAT_INTERVAL,
+        ZERO_SAMPLE_INTERVAL,
+        USB_MAX_GAIN,
+        USB_NO_TRIGGER_BUTTON,
+        X_AXIS_ENABLE,
+        0,
+        0,
+        ZERO_START_DELAY);
+    SetReport<SetPeriodic_Ext>(effectBlock, 1000, 0, 0, 8);
+
+    // without a table only the offset plays
+    SetReport<EffectOperation_Ext>(effectBlock, 1);
+    int forces[2] = {0};
+    ffe->ForceCalculator(forces);
+    EXPECT_EQ(forces[0], 0);
+
+    // the table is uploaded in two parts
+    const int16_t points[4] = {0, USB_MAX_WAVETABLE_POINT, 0, -USB_MAX_WAVETABLE_POINT};
+    SetReport<SetWavetableData_Ext>(effectBlock, 4, 0, &points[0], 2);
+    SetReport<SetWavetableData_Ext>(effectBlock, 4, 2, &points[2], 2);
+
+    // one pass through the table per period, interpolated between the points
+    const int expected[10] = {0, 500, 1000, 500, 0, -500, -1000, -500, 0, 500};
+    for (int time = 0; time < 10; ++time)
+    {
+        SetFakeTime(time);
+        ffe->ForceCalculator(forces);
+        EXPECT_NEAR(forces[0], expected[time], 1);
+    }
+
+    // phase shifts the table like the other periodic effects
+    SetReport<SetPeriodic_Ext>(effectBlock, 1000, 100, USB_MAX_PHASE / 4, 8);
+    SetFakeTime(8);
+    ffe->ForceCalculator(forces);
+    EXPECT_NEAR(forces[0], 1100, 1);
+
+    // the average sums the trapezoids between the points
+    SetReport<SetPeriodic_Ext>(effectBlock, 1000, 100, 0, 8);
+    ffe->ForceAverage(0, 8, forces);
+    EXPECT_NEAR(forces[0], 100, 1);
+    ffe->ForceAverage(0, 2, forces);
+    EXPECT_NEAR(forces[0], 600, 1);
+    ffe->ForceAverage(1, 3, forces);
+    EXPECT_NEAR(forces[0], 850, 1);
+
+    SetReport<BlockFree_Ext>(effectBlock);
+    EXPECT_EQ(ffh->GetWavetable(effectBlock - 1), nullptr);
+}
+
+TEST_F(HidAbstractor, TestResponseCurve)
+{
+    ResetFakeTime();
+
+    int springBlocks[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        springBlocks[i] = CreateEffect(
+            USB_EFFECT_SPRING,
+            USB_DURATION_INFINITE,
+            ZERO_TRIGGER_REPEAT_INTERVAL,
+            ZERO_SAMPLE_INTERVAL,
+            USB_MAX_GAIN,
+            USB_NO_TRIGGER_BUTTON,
+            X_AXIS_ENABLE,
+            0,
+            0,
+            ZERO_START_DELAY);
+        SetReport<SetCondition_Ext>(springBlocks[i], 0, 0, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, USB_MAX_GAIN, 0);
+    }
+    SetReport<EffectOperation_Ext>(springBlocks[0], 1);
+
+    // progressive spring, a quarter of the linear force at half travel
+    const int16_t points[3] = {0, USB_MAX_RESPONSE_CURVE_POINT / 4, USB_MAX_RESPONSE_CURVE_POINT};
+    SetReport<SetResponseCurve_Ext>(springBlocks[0], 0, points, 3);
+
+    int forces[2] = {0};
+    const int32_t positions[5] = {-USB_AXIS_MAX_ABSOLUTE, -USB_AXIS_MAX_ABSOLUTE / 2, 0, USB_AXIS_MAX_ABSOLUTE / 2, USB_AXIS_MAX_ABSOLUTE};
+    const int expected[5] = {255, 64, 0, -64, -255};
+    for (int i = 0; i < 5; ++i)
+    {
+        UpdatePosition({positions[i], 0});
+        ffe->ForceCalculator(forces);
+        EXPECT_NEAR(forces[0], expected[i], 1);
+    }
+
+    // a linear spring next to it still uses the merged curves
+    SetReport<EffectOperation_Ext>(springBlocks[1], 1);
+    UpdatePosition({USB_AXIS_MAX_ABSOLUTE / 2, 0});
+    ffe->ForceCalculator(forces);
+    EXPECT_NEAR(forces[0], -64 - 127, 1);
+
+    // without points the condition is linear again
+    SetReport<SetResponseCurve_Ext>(springBlocks[0], 0, points, 0);
+    EXPECT_EQ(ffh->GetResponseCurve(springBlocks[0] - 1, 0), nullptr);
+    ffe->ForceCalculator(forces);
+    EXPECT_NEAR(forces[0], -255, 1);
+}
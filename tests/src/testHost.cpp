@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "FfbDeviceManager.h"
+#include "HIDReportType.h"
+#include "helpers/hidTypesExt.hpp"
+
+template <typename T>
+static void SendReport(FfbDevice &device, const T &report, uint64_t time)
+{
+    device.reportHandler.FfbOnUsbData((uint8_t *)&report, sizeof(T), time);
+}
+
+static void StartConstantForce(FfbDevice &device, int16_t magnitude, uint64_t time)
+{
+    USB_FFBReport_CreateNewEffect_Feature_Data_t createEffect = {};
+    device.reportHandler.FfbOnCreateNewEffect(&createEffect);
+    uint8_t effectBlock = device.reportHandler.FfbOnPIDBlockLoad()[1];
+
+    SendReport(device, SetEffect_Ext(effectBlock, USB_EFFECT_CONSTANT, USB_DURATION_INFINITE, 0, 0, USB_MAX_GAIN, USB_NO_TRIGGER_BUTTON, X_AXIS_ENABLE, 0, 0, 0), time);
+    SendReport(device, SetConstantForce_Ext(effectBlock, magnitude), time);
+    SendReport(device, EffectOperation_Ext(effectBlock, 1), time);
+}
+
+TEST(DeviceManager, TestIndependentDevices)
+{
+    const uint32_t deviceCount = 16;
+    FfbDeviceManager manager(deviceCount, 4);
+    ASSERT_EQ(manager.GetDeviceCount(), deviceCount);
+
+    for (uint32_t i = 0; i < deviceCount; ++i)
+        StartConstantForce(manager.GetDevice(i), i * 10, 0);
+
+    for (uint64_t time = 0; time < 10; ++time)
+        manager.Tick(time);
+
+    for (uint32_t i = 0; i < deviceCount; ++i)
+    {
+        EXPECT_EQ(manager.GetDevice(i).force[0], (int32_t)(i * 10));
+        EXPECT_EQ(manager.GetStats(i).ticks, 10u);
+        EXPECT_LE(manager.GetStats(i).minNanos, manager.GetStats(i).maxNanos);
+    }
+
+    SendReport(manager.GetDevice(3), DeviceGain_Ext(0), 10);
+    manager.Tick(10);
+    EXPECT_EQ(manager.GetDevice(3).force[0], 0);
+    EXPECT_EQ(manager.GetDevice(4).force[0], 40);
+
+    manager.ResetStats();
+    EXPECT_EQ(manager.GetStats(0).ticks, 0u);
+}
+
+TEST(DeviceManager, TestParallelEvaluation)
+{
+    FfbDevice serial;
+    FfbDevice parallel;
+    FfbWorkerPool pool(3);
+    parallel.engine.SetParallelEvaluation(FfbWorkerPool::ParallelFor, &pool, 2);
+
+    for (int i = 0; i < MAX_EFFECTS; ++i)
+    {
+        for (FfbDevice *device : {&serial, &parallel})
+        {
+            USB_FFBReport_CreateNewEffect_Feature_Data_t createEffect = {};
+            device->reportHandler.FfbOnCreateNewEffect(&createEffect);
+            uint8_t effectBlock = device->reportHandler.FfbOnPIDBlockLoad()[1];
+
+            SendReport(*device, SetEffect_Ext(effectBlock, USB_EFFECT_SINE, USB_DURATION_INFINITE, 0, 0, USB_MAX_GAIN - i, USB_NO_TRIGGER_BUTTON, X_AXIS_ENABLE | Y_AXIS_ENABLE, 0, 0, 0), 0);
+            SendReport(*device, SetPeriodic_Ext(effectBlock, 100 + i, i, i * 100, 50 + i), 0);
+            SendReport(*device, EffectOperation_Ext(effectBlock, 1), 0);
+        }
+    }
+
+    for (uint64_t time = 0; time < 200; ++time)
+    {
+        serial.engine.ForceCalculator(time, serial.force);
+        parallel.engine.ForceCalculator(time, parallel.force);
+        ASSERT_EQ(serial.force[0], parallel.force[0]) << "time " << time;
+        ASSERT_EQ(serial.force[1], parallel.force[1]) << "time " << time;
+    }
+}
+
+TEST(WorkerPool, TestNestedRun)
+{
+    struct Context
+    {
+        FfbWorkerPool *pool;
+        std::atomic<uint32_t> jobs;
+    } context = {nullptr, {0}};
+    FfbWorkerPool pool(2);
+    context.pool = &pool;
+
+    // a job that runs a batch on its own pool, like an engine with parallel evaluation ticked by the pool
+    pool.Run([](void *outerContext, uint32_t)
+             {
+                 Context *context = (Context *)outerContext;
+                 context->pool->Run([](void *innerContext, uint32_t)
+                                    { ++((Context *)innerContext)->jobs; },
+                                    context, 3);
+             },
+             &context, 4);
+    EXPECT_EQ(context.jobs, 12u);
+}
+
+TEST(WorkerPool, TestConcurrentRun)
+{
+    FfbWorkerPool pool(4);
+    std::atomic<uint32_t> jobs[3] = {{0}, {0}, {0}};
+
+    // devices sharing one pool tick from their own threads, their batches must not mix
+    std::thread callers[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        callers[i] = std::thread([&pool, &jobs, i]
+                                 {
+                                     for (int batch = 0; batch < 2000; ++batch)
+                                     {
+                                         uint32_t before = jobs[i];
+                                         pool.Run([](void *context, uint32_t)
+                                                  { ++*(std::atomic<uint32_t> *)context; },
+                                                  &jobs[i], 8);
+                                         EXPECT_EQ(jobs[i], before + 8);
+                                     }
+                                 });
+    }
+    for (int i = 0; i < 3; ++i)
+        callers[i].join();
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(jobs[i], 16000u);
+}